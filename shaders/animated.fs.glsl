@@ -5,6 +5,7 @@ in vec2 texcoord;
 
 // Application data
 uniform sampler2D sampler0;
+uniform vec4 texrect; // where the sprite sheet is in its atlas page
 uniform int current_frame;
 uniform int num_frames;
 uniform vec3 fcolor;
@@ -20,5 +21,5 @@ void main()
 	// Slide texture coordinate to the next frame or sprite
 	new_texcoord.x += current_frame * 1.0 / num_frames;
 	
-	color = vec4(fcolor, 1.0) * texture(sampler0, new_texcoord);
+	color = vec4(fcolor, 1.0) * texture(sampler0, texrect.xy + new_texcoord * texrect.zw);
 }
@@ -8,6 +8,7 @@ uniform sampler2D sampler0;
 uniform sampler2D sampler1;
 uniform sampler2D sampler2;
 uniform sampler2D sampler3;
+uniform vec4 texrect[4]; // where the texture of each sampler is in its atlas page
 uniform int current_health;
 uniform int max_health_damage;
 uniform int current_damage;
@@ -16,11 +17,20 @@ uniform vec3 fcolor;
 // Output color
 layout(location = 0) out vec4 color;
 
+// Samples a texture of the atlas, outside of it the texture is transparent like its own
+// texture with a transparent border would be
+vec4 atlas(sampler2D page, vec4 rect, vec2 coord)
+{
+	if (any(lessThan(coord, vec2(0.0))) || any(greaterThan(coord, vec2(1.0))))
+		return vec4(0.0);
+	return texture(page, rect.xy + coord * rect.zw);
+}
+
 void main()
 {
 	// Use hard coded scale and position, accounting for card frame texture
-	vec4 biome = texture(sampler0, texcoord * vec2(3, 3.78) - vec2(1.0, 0.25));
-	vec4 card = texture(sampler1, texcoord);
+	vec4 biome = atlas(sampler0, texrect[0], texcoord * vec2(3, 3.78) - vec2(1.0, 0.25));
+	vec4 card = atlas(sampler1, texrect[1], texcoord);
 
 	// Apply over operator using premultiplied alpha
 	// https://en.wikipedia.org/wiki/Alpha_compositing
@@ -40,7 +50,7 @@ void main()
 		vec2 scale = vec2(max_health_damage + 1.0, max_health_damage + 2.5);
 		vec2 position = vec2(i + 0.5, max_health_damage);
 		
-		health = texture(sampler2, texcoord * scale - position);
+		health = atlas(sampler2, texrect[2], texcoord * scale - position);
 		
 		health.rgb *= health.a;
 		rgb_adder += health.rgb;
@@ -57,7 +67,7 @@ void main()
 		vec2 scale = vec2(max_health_damage + 1.0, max_health_damage + 2.5);
 		vec2 position = vec2(i + 0.5, max_health_damage + 1);
 		
-		damage = texture(sampler3, texcoord * scale - position);
+		damage = atlas(sampler3, texrect[3], texcoord * scale - position);
 		
 		damage.rgb *= damage.a;
 		rgb_adder += damage.rgb;
@@ -0,0 +1,19 @@
+#version 330
+
+// Input attributes
+in vec3 in_position;
+in vec3 in_color;
+
+// Passed to fragment shader
+out vec3 vcolor;
+
+// Application data
+uniform mat3 projection;
+
+void main()
+{
+	// The vertices are already in window coordinates
+	vcolor = in_color;
+	vec3 pos = projection * vec3(in_position.xy, 1.0);
+	gl_Position = vec4(pos.xy, in_position.z, 1.0);
+}
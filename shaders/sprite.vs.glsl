@@ -0,0 +1,26 @@
+#version 330
+
+// Input attributes
+in vec3 in_position;
+in vec2 in_texcoord;
+
+// Instance attributes
+in mat3 in_transform;
+in vec4 in_texrect;
+in vec3 in_color;
+
+// Passed to fragment shader
+out vec2 texcoord;
+out vec3 vcolor;
+
+// Application data
+uniform mat3 projection;
+
+void main()
+{
+	// Offset and scale the texture coordinates, e.g. to the current frame of a sprite sheet
+	texcoord = in_texrect.xy + in_texcoord * in_texrect.zw;
+	vcolor = in_color;
+	vec3 pos = projection * in_transform * vec3(in_position.xy, 1.0);
+	gl_Position = vec4(pos.xy, in_position.z, 1.0);
+}
@@ -0,0 +1,27 @@
+#version 330
+
+// From vertex shader
+in vec2 texcoord;
+
+// Application data
+uniform sampler2D sampler0; // path texture
+uniform sampler2D sampler1; // wall texture
+uniform usampler2D sampler2; // one texel per tile, 1 for a wall
+uniform vec4 texrect[2]; // where the path and wall textures are in their atlas pages
+
+// Output color
+layout(location = 0) out vec4 color;
+
+void main()
+{
+	// The quad covers the whole map, find the tile and the position within it
+	ivec2 size = textureSize(sampler2, 0);
+	vec2 position = texcoord * vec2(size);
+	ivec2 tile = clamp(ivec2(floor(position)), ivec2(0), size - 1);
+	vec2 local = position - vec2(tile);
+
+	// Both are sampled so that the texture lookups stay in uniform control flow
+	vec4 path = texture(sampler0, texrect[0].xy + local * texrect[0].zw);
+	vec4 wall = texture(sampler1, texrect[1].xy + local * texrect[1].zw);
+	color = texelFetch(sampler2, tile, 0).r != 0u ? wall : path;
+}
@@ -5,6 +5,7 @@
 #include <random>
 
 #include "common.hpp"
+#include "task_scheduler.hpp"
 #include "tiny_ecs_registry.hpp"
 #include "world_init.hpp"
 
@@ -15,7 +16,15 @@ public:
 
 	void init(RenderSystem* renderer);
 
-	void step(float elapsed_ms);
+	// Counts down the thinking time of the boss and decides its next move, only changes values
+	// so it can run alongside the animations and the movement
+	void think(float elapsed_ms);
+	static constexpr TaskAccess THINK_ACCESS = {
+		GameRegistry::mask<Player, Boss, BossPlay>(), GameRegistry::mask<Battle, BossModeTimer>() };
+
+	// Carries out the moves decided by think(), creating, placing and playing cards
+	void act(float elapsed_ms);
+	static constexpr TaskAccess ACT_ACCESS = STRUCTURAL_ACCESS;
 private:
 	// Game state
 	RenderSystem* renderer;
@@ -23,6 +32,22 @@ private:
 	// Card battle references
 	Entity selected_card;
 
+	// Moves of the boss, decided by think() and carried out by act()
+	enum class BOSS_MOVE
+	{
+		SELECT = 0, // draw a card unless the board is full, then think
+		PLACE = SELECT + 1, // put the selected card in play unless the board is full, then think
+		PLAY = PLACE + 1,
+		END_TURN = PLAY + 1
+	};
+	struct PendingMove {
+		Entity boss;
+		BOSS_MOVE move;
+		bool is_board_full;
+	};
+	std::vector<PendingMove> pending_moves;
+	std::vector<Entity> finished_timers; // thinking times that ran out
+
 	// C++ random number generator
 	std::default_random_engine rng;
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+// internal
+#include "asset_pack.hpp"
+
+#include "../ext/project_path.hpp"
+
+// stlib
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+AssetPack asset_pack;
+
+bool AssetPack::open(const std::string& path)
+{
+	close();
+
+	// Map the whole file read only, it stays mapped for as long as the game runs
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	size = (size_t)file_size.QuadPart;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != nullptr)
+		data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat file_stat;
+	if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0)
+	{
+		size = (size_t)file_stat.st_size;
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped != MAP_FAILED)
+			data = (const uint8_t*)mapped;
+	}
+	::close(file);
+#endif
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	// Check the header and that the table of contents fits
+	const AssetPackHeader* header = (const AssetPackHeader*)data;
+	if (size < sizeof(AssetPackHeader) || memcmp(header->magic, "IOLS", 4) != 0 ||
+		header->version != ASSET_PACK_VERSION ||
+		size < sizeof(AssetPackHeader) + (uint64_t)header->entry_count * sizeof(AssetPackEntry))
+	{
+		fprintf(stderr, "Ignoring the asset pack %s, it was written by another version of the packer\n", path.c_str());
+		close();
+		return false;
+	}
+	entries = (const AssetPackEntry*)(data + sizeof(AssetPackHeader));
+	entry_count = header->entry_count;
+	return true;
+}
+
+void AssetPack::close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	mapping = file = nullptr;
+#else
+	if (data)
+		munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+	entries = nullptr;
+	entry_count = 0;
+}
+
+const AssetPackEntry* AssetPack::find(const std::string& path) const
+{
+	if (!is_open())
+		return nullptr;
+
+	const std::string name = entry_name(path);
+	for (uint32_t i = 0; i < entry_count; i++)
+	{
+		const AssetPackEntry& entry = entries[i];
+		if (strncmp(entry.name, name.c_str(), sizeof(entry.name)) != 0)
+			continue;
+		if (entry.offset + entry.size > size)
+			return nullptr;
+
+		// A source file that is gone is fine, the pack can ship without them
+		int64_t time;
+		uint64_t source_size;
+		if (source_info(path, time, source_size) && (time != entry.source_time || source_size != entry.source_size))
+		{
+			fprintf(stderr, "The asset pack is stale for %s, loading the file instead\n", name.c_str());
+			return nullptr;
+		}
+		return &entry;
+	}
+	return nullptr;
+}
+
+std::string AssetPack::entry_name(const std::string& path)
+{
+	// Paths are built from the project directory, e.g. PROJECT_SOURCE_DIR + "/shaders/" + name
+	const std::string project = PROJECT_SOURCE_DIR;
+	size_t start = path.compare(0, project.size(), project) == 0 ? project.size() : 0;
+	while (start < path.size() && path[start] == '/')
+		start++;
+	return path.substr(start);
+}
+
+bool AssetPack::source_info(const std::string& path, int64_t& time, uint64_t& size)
+{
+	struct stat file_stat;
+	if (stat(path.c_str(), &file_stat) != 0)
+		return false;
+	time = (int64_t)file_stat.st_mtime;
+	size = (uint64_t)file_stat.st_size;
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Asset pack
+// The packer in tools/ bakes the textures as raw RGBA, the shader sources and the audio into
+// one file. At startup the file is mapped into memory once and assets are read straight from
+// the mapping, instead of opening, reading and decoding every file on its own. An entry whose
+// source file has changed since it was packed is stale and not returned, callers then load
+// the loose file instead.
+//
+// Layout: an AssetPackHeader, entry_count AssetPackEntry, then the data of the entries, each
+// aligned to ASSET_PACK_ALIGNMENT bytes
+const uint32_t ASSET_PACK_VERSION = 1;
+const uint64_t ASSET_PACK_ALIGNMENT = 16;
+
+enum class ASSET_KIND : uint32_t
+{
+	TEXTURE = 0,
+	SHADER = TEXTURE + 1,
+	AUDIO = SHADER + 1
+};
+
+struct AssetPackHeader
+{
+	char magic[4]; // "IOLS"
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t reserved;
+};
+
+struct AssetPackEntry
+{
+	char name[64]; // path relative to the project directory, e.g. data/textures/npc.png
+	ASSET_KIND kind;
+	uint32_t width, height; // textures only, in pixels
+	uint32_t reserved;
+	uint64_t offset, size; // of the data, from the start of the file
+	int64_t source_time; // modification time of the source file when it was packed
+	uint64_t source_size;
+};
+
+class AssetPack
+{
+public:
+	AssetPack() = default;
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+	~AssetPack() { close(); }
+
+	// Maps the pack, returns false if it is missing or was written by another version
+	bool open(const std::string& path);
+	void close();
+	bool is_open() const { return data != nullptr; }
+
+	// The entry of a file by its full path, e.g. textures_path("npc.png")
+	// nullptr if the file is not packed or its entry is stale
+	const AssetPackEntry* find(const std::string& path) const;
+	const uint8_t* contents(const AssetPackEntry& entry) const { return data + entry.offset; }
+
+	// Name of the entry of a full path, the path relative to the project directory
+	static std::string entry_name(const std::string& path);
+	// Modification time and size of a file, false if it does not exist
+	static bool source_info(const std::string& path, int64_t& time, uint64_t& size);
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	const AssetPackEntry* entries = nullptr;
+	uint32_t entry_count = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// The asset pack of the game, opened by main before anything is loaded
+extern AssetPack asset_pack;
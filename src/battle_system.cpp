@@ -31,7 +31,8 @@ Entity& get_card_player_deck() {
 		card,
 		{ used_texture,
 		  EFFECT_ASSET_ID::CARD,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::CARD });
 
 	// Add card to current hand and remove it from the deck
 	registry.playerDecks.remove(card);
@@ -55,7 +56,7 @@ bool card_placement_unoccupied(vec2 position, ComponentContainer<Play>& play_reg
 	bool unoccupied = true;
 
 	auto& motion_registry = registry.motions;
-	for (int i = (int)play_registry.components.size() - 1; i >= 0; i--) {
+	for (int i = (int)play_registry.size() - 1; i >= 0; i--) {
 		Motion& motion = motion_registry.get(play_registry.entities[i]);
 
 		// Cannot place card here if there is already one present
@@ -76,7 +77,7 @@ vec2 choose_placement_player_hand() {
 	auto& hand_registry = registry.playerHands;
 	auto& motion_registry = registry.motions;
 	for (int i = 0; i < MAX_HAND; i++) {
-		for (int j = (int)hand_registry.components.size() - 1; j >= 0; j--) {
+		for (int j = (int)hand_registry.size() - 1; j >= 0; j--) {
 			Motion& motion = motion_registry.get(hand_registry.entities[j]);
 			placement = { (i + 0.5) * window_width_px / MAX_PLAY, CARD_PLAYER_HAND_HEIGHT };
 
@@ -100,7 +101,7 @@ void play_cards(ComponentContainer<Play>& player_play_registry,
 	ComponentContainer<Play>& opponent_play_registry, 
 	ComponentContainer<BoardUI>& opponent_bar, Entity& opponent) {
 	auto& motion_registry = registry.motions;
-	for (int i = (int)player_play_registry.components.size() - 1; i >= 0; i--) {
+	for (int i = (int)player_play_registry.size() - 1; i >= 0; i--) {
 		Entity card = player_play_registry.entities[i];
 		Motion& motion = motion_registry.get(card);
 		Damage& damage = registry.damageComponents.get(card);
@@ -116,7 +117,7 @@ void play_cards(ComponentContainer<Play>& player_play_registry,
 		motion_bar.position.x = motion_bar.scale.x / 2.f;
 
 		// For every enemy card at play...
-		for (int j = (int)opponent_play_registry.components.size() - 1; j >= 0; j--) {
+		for (int j = (int)opponent_play_registry.size() - 1; j >= 0; j--) {
 			Entity card_other = opponent_play_registry.entities[j];
 			Motion& motion_other = registry.motions.get(card_other);
 
@@ -30,6 +30,8 @@ inline std::string textures_path(const std::string& name) {return data_path() +
 inline std::string audio_path(const std::string& name) {return data_path() + "/audio/" + std::string(name);};
 inline std::string mesh_path(const std::string& name) {return data_path() + "/meshes/" + std::string(name);};
 inline std::string save_path(const std::string& name) { return data_path() + "/save/" + std::string(name); };
+inline std::string shader_cache_path(const std::string& name) { return data_path() + "/shader_cache/" + std::string(name); };
+inline std::string trace_path(const std::string& name) { return data_path() + "/traces/" + std::string(name); };
 
 // Size divided by tile size should be odd for maze generation to work
 const int window_width_px = 960;
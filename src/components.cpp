@@ -9,6 +9,7 @@
 #include <sstream>
 
 Debug debugging;
+DebugDraw debug_draw;
 float death_timer_counter_ms = 3000;
 
 // Very, VERY simple OBJ loader from https://github.com/opengl-tutorials/ogl tutorial 7
@@ -119,3 +120,31 @@ bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out
 
 	return true;
 }
+
+void DebugDraw::line(vec2 from, vec2 to, vec3 color)
+{
+	vertices.push_back({ vec3(from, 0.f), color });
+	vertices.push_back({ vec3(to, 0.f), color });
+}
+
+void DebugDraw::box(vec2 center, vec2 size, vec3 color)
+{
+	const vec2 half = abs(size) / 2.f;
+	const vec2 corners[] = {
+		center + vec2(-half.x, -half.y), center + vec2(half.x, -half.y),
+		center + vec2(half.x, half.y), center + vec2(-half.x, half.y) };
+	for (int i = 0; i < 4; i++)
+		line(corners[i], corners[(i + 1) % 4], color);
+}
+
+void DebugDraw::circle(vec2 center, float radius, vec3 color, int segments)
+{
+	vec2 previous = center + vec2(radius, 0.f);
+	for (int i = 1; i <= segments; i++)
+	{
+		const float angle = 2.f * M_PI * i / segments;
+		const vec2 next = center + radius * vec2(cos(angle), sin(angle));
+		line(previous, next, color);
+		previous = next;
+	}
+}
@@ -144,18 +144,28 @@ struct Tier
 // Structure to store path information
 struct Path {
 	vec2 next = { -1, -1 }; // current step on way to destination
-	std::stack<vec2> path_stack; // list of postions to travel to on way to destination
+	std::vector<vec2> path_stack; // postions to travel to on way to destination, the next one at the back
 };
 
 // All data relevant to the shape and motion of entities
 struct Motion 
 {
 	vec2 position = { 0, 0 };
+	// Position before the last simulation tick, the renderer draws in between the two
+	vec2 previous_position = { 0, 0 };
 	float angle = 0;
 	vec2 velocity = { 0, 0 };
 	vec2 scale = { 10, 10 };
 	bool is_enroute = false;
-	struct Path* path;
+	Path path;
+};
+
+// Shape a static body was counted with in the navigation grid of WorldSystem, so that it can be
+// taken out again exactly as it was added
+struct NavigationObstacle
+{
+	vec2 position = { 0, 0 };
+	vec2 scale = { 10, 10 };
 };
 
 // Enumerator to represent current mode of card battle
@@ -181,7 +191,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	Collision(Entity& other) : other(other) {}; // copying avoids allocating a throwaway entity
 };
 
 // Structure to store spritesheet information
@@ -208,12 +218,6 @@ struct Debug
 };
 extern Debug debugging;
 
-// A struct to refer to debugging graphics in the ECS
-struct DebugComponent
-{
-	// Note, an empty struct has size 1
-};
-
 // Enumerator to represent current screen state
 enum class STATE_ID
 {
@@ -278,6 +282,20 @@ struct TexturedVertex
 	vec2 texcoord;
 };
 
+// Lines drawn on top of everything else for debugging, in window coordinates
+// Systems append primitives while stepping, the render system draws all of them with a single
+// draw call and WorldSystem::step clears them for the next step. No entities are involved.
+struct DebugDraw
+{
+	std::vector<ColoredVertex> vertices; // two per line
+
+	void line(vec2 from, vec2 to, vec3 color);
+	void box(vec2 center, vec2 size, vec3 color);
+	void circle(vec2 center, float radius, vec3 color, int segments = 24);
+	void clear() { vertices.clear(); }
+};
+extern DebugDraw debug_draw;
+
 // Mesh datastructure for storing vertex and index buffers
 struct Mesh
 {
@@ -389,7 +407,10 @@ enum class EFFECT_ASSET_ID
 	ANIMATED = CARD + 1,
 	TEXTURED = ANIMATED + 1,
 	WIND = TEXTURED + 1,
-	EFFECT_COUNT = WIND + 1
+	SPRITE = WIND + 1, // instanced sprites, used internally by RenderSystem for TEXTURED and ANIMATED
+	TILEMAP = SPRITE + 1,
+	DEBUG_LINES = TILEMAP + 1, // the lines of DebugDraw, used internally by RenderSystem
+	EFFECT_COUNT = DEBUG_LINES + 1
 };
 const int effect_count = (int)EFFECT_ASSET_ID::EFFECT_COUNT;
 
@@ -403,9 +424,49 @@ enum class GEOMETRY_BUFFER_ID
 };
 const int geometry_count = (int)GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
 
+// Layers are drawn back to front; within a layer the order is chosen to save state changes
+enum class RENDER_LAYER
+{
+	BACKGROUND = 0,
+	TILE = BACKGROUND + 1,
+	PROP = TILE + 1,
+	ACTOR = PROP + 1,
+	PLAYER = ACTOR + 1,
+	CARD = PLAYER + 1,
+	UI = CARD + 1,
+	OVERLAY = UI + 1,
+	OVERLAY_UI = OVERLAY + 1,
+	LAYER_COUNT = OVERLAY_UI + 1
+};
+
 struct RenderRequest 
 {
 	TEXTURE_ASSET_ID used_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
 	EFFECT_ASSET_ID used_effect = EFFECT_ASSET_ID::EFFECT_COUNT;
 	GEOMETRY_BUFFER_ID used_geometry = GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
-};
\ No newline at end of file
+	RENDER_LAYER used_layer = RENDER_LAYER::ACTOR;
+};
+
+// The path and wall tiles of a screen, drawn in a single draw call by the tilemap effect
+// Walls are not entities; collisions and pathfinding look them up in the grid.
+struct TileMap
+{
+	int columns = 0;
+	int rows = 0;
+	vec2 tile_size = { 0, 0 };
+	std::vector<uint8_t> walls; // 1 for a wall, row by row
+	TEXTURE_ASSET_ID path_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
+	TEXTURE_ASSET_ID wall_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
+	bool is_uploaded = false; // whether RenderSystem has the current walls in its tile texture
+
+	// Tiles outside of the map are not walls
+	bool is_wall(int column, int row) const {
+		return column >= 0 && column < columns && row >= 0 && row < rows && walls[row * columns + column] != 0;
+	}
+	bool is_wall_at(vec2 position) const {
+		return is_wall((int)floor(position.x / tile_size.x), (int)floor(position.y / tile_size.y));
+	}
+	vec2 tile_center(int column, int row) const {
+		return { (column + 0.5f) * tile_size.x, (row + 0.5f) * tile_size.y };
+	}
+};
@@ -0,0 +1,121 @@
+// internal
+#include "input_script.hpp"
+#include "world_system.hpp"
+
+// stlib
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace {
+	// A GLFW key code by name, -1 if the name is unknown
+	int parse_key(const std::string& name) {
+		if (std::all_of(name.begin(), name.end(), [](char c) { return std::isdigit((unsigned char)c); }) && name.size() > 1)
+			return std::stoi(name);
+		// Printable keys are their upper case ASCII code in GLFW
+		if (name.size() == 1 && std::isalnum((unsigned char)name[0]))
+			return std::toupper((unsigned char)name[0]);
+		if (name == "space") return GLFW_KEY_SPACE;
+		if (name == "escape") return GLFW_KEY_ESCAPE;
+		if (name == "up") return GLFW_KEY_UP;
+		if (name == "down") return GLFW_KEY_DOWN;
+		if (name == "left") return GLFW_KEY_LEFT;
+		if (name == "right") return GLFW_KEY_RIGHT;
+		return -1;
+	}
+
+	int parse_action(const std::string& name) {
+		if (name == "press") return GLFW_PRESS;
+		if (name == "release") return GLFW_RELEASE;
+		if (name == "repeat") return GLFW_REPEAT;
+		return -1;
+	}
+}
+
+bool InputScript::load(const std::string& path)
+{
+	events.clear();
+	next = 0;
+
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		fprintf(stderr, "Failed to open input script %s\n", path.c_str());
+		return false;
+	}
+
+	std::string line;
+	for (int line_number = 1; std::getline(file, line); line_number++)
+	{
+		std::istringstream words(line);
+		std::string kind;
+		Event event = {};
+		if (!(words >> event.tick))
+		{
+			// Empty lines and comments
+			words.clear();
+			words.seekg(0);
+			if (!(words >> kind) || kind[0] == '#')
+				continue;
+			fprintf(stderr, "%s:%d: expected a tick: %s\n", path.c_str(), line_number, line.c_str());
+			return false;
+		}
+
+		bool is_valid = bool(words >> kind);
+		if (is_valid && kind == "key")
+		{
+			std::string key, action;
+			event.kind = EVENT_KIND::KEY;
+			is_valid = bool(words >> key >> action);
+			event.key = parse_key(key);
+			event.action = parse_action(action);
+			is_valid = is_valid && event.key >= 0 && event.action >= 0;
+		}
+		else if (is_valid && (kind == "move" || kind == "click"))
+		{
+			event.kind = kind == "move" ? EVENT_KIND::MOVE : EVENT_KIND::CLICK;
+			is_valid = bool(words >> event.position.x >> event.position.y);
+		}
+		else if (is_valid && kind == "quit")
+			event.kind = EVENT_KIND::QUIT;
+		else
+			is_valid = false;
+
+		if (!is_valid)
+		{
+			fprintf(stderr, "%s:%d: invalid event: %s\n", path.c_str(), line_number, line.c_str());
+			return false;
+		}
+		events.push_back(event);
+	}
+
+	std::stable_sort(events.begin(), events.end(),
+		[](const Event& a, const Event& b) { return a.tick < b.tick; });
+	return true;
+}
+
+void InputScript::play(WorldSystem& world, uint64_t tick)
+{
+	for (; next < events.size() && events[next].tick <= tick; next++)
+	{
+		const Event& event = events[next];
+		switch (event.kind)
+		{
+		case EVENT_KIND::KEY:
+			world.on_key(event.key, 0, event.action, 0);
+			break;
+		case EVENT_KIND::MOVE:
+			world.on_mouse_move(event.position);
+			break;
+		case EVENT_KIND::CLICK:
+			world.on_mouse_move(event.position);
+			world.on_mouse_button(GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0);
+			world.on_mouse_button(GLFW_MOUSE_BUTTON_LEFT, GLFW_RELEASE, 0);
+			break;
+		case EVENT_KIND::QUIT:
+			world.on_key(GLFW_KEY_ESCAPE, 0, GLFW_RELEASE, 0);
+			break;
+		}
+	}
+}
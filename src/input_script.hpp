@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+class WorldSystem;
+
+// Scripted input of a headless run
+// A text file with one input event per line, played back at the start of the tick it names:
+//   <tick> key <key> <press|release|repeat>
+//   <tick> move <x> <y>
+//   <tick> click <x> <y>
+//   <tick> quit
+// A key is a GLFW key code, a letter or digit, or one of space, escape, up, down, left and
+// right. A click moves the mouse and presses and releases the left button. Lines starting
+// with # are comments. Events of the same tick are played in file order.
+class InputScript
+{
+public:
+	// Reads the script, returns false and prints the offending line if it cannot be parsed
+	bool load(const std::string& path);
+
+	// Plays the events of ticks up to and including tick
+	void play(WorldSystem& world, uint64_t tick);
+
+	// Whether every event has been played
+	bool is_done() const { return next == events.size(); }
+
+private:
+	enum class EVENT_KIND
+	{
+		KEY = 0,
+		MOVE = KEY + 1,
+		CLICK = MOVE + 1,
+		QUIT = CLICK + 1
+	};
+
+	struct Event {
+		uint64_t tick;
+		EVENT_KIND kind;
+		int key, action; // KEY only
+		vec2 position; // MOVE and CLICK only
+	};
+	std::vector<Event> events; // in tick order
+	size_t next = 0;
+};
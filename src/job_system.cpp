@@ -0,0 +1,109 @@
+// internal
+#include "job_system.hpp"
+
+JobSystem job_system;
+
+namespace {
+	// Queue of the worker running on this thread, 0 for threads outside of any pool
+	thread_local const JobSystem* worker_pool = nullptr;
+	thread_local size_t worker_queue = 0;
+}
+
+void JobSystem::start(unsigned int worker_count)
+{
+	stop();
+	is_stopping = false;
+	while (queues.size() < (size_t)worker_count + 1)
+		queues.push_back(std::make_unique<Queue>());
+	for (size_t w = 1; w <= worker_count; w++)
+		threads.emplace_back([this, w]() { work_loop(w); });
+}
+
+void JobSystem::stop()
+{
+	if (threads.empty())
+		return;
+	// The workers leave once the queues are empty
+	wait_until([this]() { return queued.load(std::memory_order_acquire) == 0; });
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		is_stopping = true;
+	}
+	sleep_condition.notify_all();
+	for (std::thread& thread : threads)
+		thread.join();
+	threads.clear();
+}
+
+JobSystem::Queue& JobSystem::queue_of_this_thread()
+{
+	return *queues[worker_pool == this ? worker_queue : 0];
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+	Queue& queue = queue_of_this_thread();
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queued.fetch_add(1, std::memory_order_release);
+
+	// Taking the lock orders this against a worker about to sleep, so the wake up is not lost
+	if (!threads.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		sleep_condition.notify_one();
+	}
+}
+
+bool JobSystem::run_one()
+{
+	if (queued.load(std::memory_order_acquire) == 0)
+		return false;
+
+	// The own jobs first, newest first, then the oldest job of any other queue
+	const size_t own = worker_pool == this ? worker_queue : 0;
+	std::function<void()> job;
+	for (size_t i = 0; i < queues.size() && !job; i++)
+	{
+		Queue& queue = *queues[(own + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+		if (i == 0)
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+	}
+	if (!job)
+		return false;
+
+	queued.fetch_sub(1, std::memory_order_relaxed);
+	job();
+	return true;
+}
+
+void JobSystem::work_loop(size_t queue)
+{
+	worker_pool = this;
+	worker_queue = queue;
+	while (true)
+	{
+		if (run_one())
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleep_condition.wait(lock, [this]() { return is_stopping || queued.load(std::memory_order_acquire) > 0; });
+		if (is_stopping)
+			return;
+	}
+}
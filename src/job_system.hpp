@@ -0,0 +1,231 @@
+#pragma once
+
+// stlib
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Job system
+// A pool of worker threads shared by the whole engine. Every worker has a deque of jobs: it
+// takes the jobs it submitted itself from the back and, when it runs out, steals from the front
+// of the others. Jobs submitted by threads outside of the pool go to a shared deque that the
+// workers steal from as well.
+//
+// Nothing ever blocks on a job: a thread that waits for one, e.g. JobFuture::get(), runs other
+// jobs meanwhile, so jobs may wait for jobs and a pool without workers runs everything on the
+// waiting thread.
+class JobSystem
+{
+public:
+	JobSystem() { queues.push_back(std::make_unique<Queue>()); }
+	~JobSystem() { stop(); }
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// One worker per hardware thread, less the thread that submits the jobs
+	static unsigned int default_worker_count()
+	{
+		return std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	// Starts the workers, while no jobs are running
+	// Jobs submitted before only run on threads waiting for them
+	void start(unsigned int worker_count);
+	// Joins the workers once they are done with the queued jobs
+	void stop();
+
+	// Threads running jobs: the workers and a thread submitting and waiting for them
+	unsigned int get_thread_count() const { return (unsigned int)threads.size() + 1; }
+
+	void submit(std::function<void()> job);
+
+	// Runs one queued job on the calling thread, returns false if there was none
+	bool run_one();
+
+	// Runs jobs on the calling thread until done() holds
+	template <typename Predicate>
+	void wait_until(Predicate done)
+	{
+		while (!done())
+		{
+			if (!run_one())
+				std::this_thread::yield();
+		}
+	}
+
+	template <typename T>
+	class Future;
+
+	// Runs f() as a job, its result is given by the future
+	template <typename F>
+	auto async(F f) -> Future<std::invoke_result_t<F&>>;
+
+	// Calls f(first, last) over consecutive ranges covering [begin, end), of at most grain
+	// items each, and returns once all are done. The calling thread runs ranges as well.
+	template <typename F>
+	void parallel_for(size_t begin, size_t end, size_t grain, const F& f);
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+	std::vector<std::unique_ptr<Queue>> queues; // queues[0] is shared, then one per worker
+	std::vector<std::thread> threads;
+	std::atomic<size_t> queued{ 0 };
+
+	std::mutex sleep_mutex; // guards is_stopping, idle workers sleep until a job is queued
+	std::condition_variable sleep_condition;
+	bool is_stopping = false;
+
+	void work_loop(size_t queue);
+	Queue& queue_of_this_thread();
+
+	// Result of a job and what to run once it is there
+	template <typename T>
+	struct State {
+		std::atomic<bool> is_ready{ false };
+		std::mutex mutex; // guards continuations
+		std::vector<std::function<void()>> continuations;
+		std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> value;
+
+		template <typename F>
+		void run(F& f)
+		{
+			if constexpr (std::is_void_v<T>)
+			{
+				f();
+				value = true;
+			}
+			else
+				value = f();
+
+			std::vector<std::function<void()>> ready;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				is_ready.store(true, std::memory_order_release);
+				ready.swap(continuations);
+			}
+			for (std::function<void()>& continuation : ready)
+				continuation();
+		}
+
+		void on_ready(std::function<void()> continuation)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!is_ready.load(std::memory_order_relaxed))
+				{
+					continuations.push_back(std::move(continuation));
+					return;
+				}
+			}
+			continuation();
+		}
+	};
+};
+
+extern JobSystem job_system;
+
+// The result of a job, see JobSystem::async()
+template <typename T>
+class JobSystem::Future
+{
+public:
+	Future() = default;
+
+	bool is_valid() const { return state != nullptr; }
+	bool is_ready() const { return state->is_ready.load(std::memory_order_acquire); }
+
+	// Waits for the job, running other jobs meanwhile
+	// The result stays with the future, get() can be called again
+	decltype(auto) get() const
+	{
+		system->wait_until([this]() { return is_ready(); });
+		if constexpr (!std::is_void_v<T>)
+			return (const T&)*state->value;
+	}
+
+	// Runs f(result), or f() for a job without result, as a job once this one is done
+	template <typename F>
+	auto then(F f) const
+	{
+		if constexpr (std::is_void_v<T>)
+			return chain(std::move(f), [](F& g, const std::shared_ptr<State<T>>&) { return g(); });
+		else
+			return chain(std::move(f), [](F& g, const std::shared_ptr<State<T>>& done) { return g(*done->value); });
+	}
+
+	// Made by JobSystem::async() and then()
+	Future(JobSystem* system_arg, std::shared_ptr<State<T>> state_arg)
+		: system(system_arg), state(std::move(state_arg)) {}
+
+private:
+	template <typename F, typename Call>
+	auto chain(F f, Call call) const
+	{
+		using Result = decltype(call(f, state));
+		std::shared_ptr<State<Result>> next = std::make_shared<State<Result>>();
+		JobSystem* pool = system;
+		std::shared_ptr<State<T>> done = state;
+		state->on_ready([pool, done, next, f, call]() mutable {
+			pool->submit([done, next, f, call]() mutable {
+				auto job = [&]() { return call(f, done); };
+				next->run(job);
+			});
+		});
+		return Future<Result>(system, next);
+	}
+
+	JobSystem* system = nullptr;
+	std::shared_ptr<State<T>> state;
+};
+
+template <typename F>
+auto JobSystem::async(F f) -> Future<std::invoke_result_t<F&>>
+{
+	using T = std::invoke_result_t<F&>;
+	std::shared_ptr<State<T>> state = std::make_shared<State<T>>();
+	submit([state, f]() mutable { state->run(f); });
+	return Future<T>(this, state);
+}
+
+template <typename F>
+void JobSystem::parallel_for(size_t begin, size_t end, size_t grain, const F& f)
+{
+	if (end <= begin)
+		return;
+	grain = std::max<size_t>(grain, 1);
+	const size_t range_count = (end - begin + grain - 1) / grain;
+
+	// Ranges are handed out one by one to whichever thread asks next
+	std::atomic<size_t> next_range(0);
+	auto run_ranges = [&]() {
+		for (size_t range = next_range++; range < range_count; range = next_range++)
+			f(begin + range * grain, std::min(end, begin + (range + 1) * grain));
+	};
+
+	// The helpers only touch this frame until they count themselves as finished
+	const size_t helper_count = std::min(range_count - 1, threads.size());
+	std::atomic<size_t> finished_helpers(0);
+	for (size_t h = 0; h < helper_count; h++)
+	{
+		submit([&]() {
+			run_ranges();
+			finished_helpers.fetch_add(1, std::memory_order_release);
+		});
+	}
+	run_ranges();
+	wait_until([&]() { return finished_helpers.load(std::memory_order_acquire) == helper_count; });
+}
+
+template <typename T>
+using JobFuture = JobSystem::Future<T>;
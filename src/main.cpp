@@ -3,25 +3,136 @@
 #include <gl3w.h>
 
 // stlib
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 // internal
 #include "ai_system.hpp"
+#include "asset_pack.hpp"
+#include "input_script.hpp"
+#include "job_system.hpp"
 #include "physics_system.hpp"
+#include "profiler.hpp"
 #include "render_system.hpp"
+#include "task_scheduler.hpp"
 #include "world_system.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
+// Fixed timestep
+// The simulation advances in ticks of the same length whatever the frame rate, so a slow frame
+// cannot move anything further per step than a fast one. After a slow frame at most
+// MAX_TICKS_PER_FRAME ticks are run to catch up and the rest of the time is dropped: the game
+// slows down for a moment instead of spending every following frame catching up.
+const float DEFAULT_TICK_RATE = 60.f; // ticks per second, overridden by --tick-rate <hz>
+const int MAX_TICKS_PER_FRAME = 5;
+
+// Stores the position every motion had before the coming tick, see RenderSystem::draw
+static void store_previous_positions()
+{
+	for (Motion& motion : registry.motions.components)
+		motion.previous_position = motion.position;
+}
+const TaskAccess STORE_PREVIOUS_POSITIONS_ACCESS = { 0, GameRegistry::mask<Motion>() };
+
+// Saves the zones of the run, see Profiler
+static void write_profile()
+{
+#ifdef IOLS_PROFILE
+	profiler.write_trace(trace_path("trace.json"));
+#endif
+}
+
+// Headless runs
+// --headless, or any run of the iols_headless build (IOLS_HEADLESS), simulates without a window,
+// GL or audio and as fast as the CPU allows, playing back the input of --script <file>, see
+// InputScript. The run ends when the game is closed or after --ticks <n> ticks.
+const uint64_t DEFAULT_HEADLESS_TICKS = 3600;
+
 // Entry point
-int main()
+int main(int argc, char* argv[])
 {
+	float tick_rate = DEFAULT_TICK_RATE;
+#ifdef IOLS_HEADLESS
+	bool is_headless = true;
+#else
+	bool is_headless = false;
+#endif
+	const char* script_path = nullptr;
+	uint64_t max_ticks = DEFAULT_HEADLESS_TICKS;
+	unsigned int job_workers = JobSystem::default_worker_count(); // --workers <n> overrides it
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+			tick_rate = std::max(1.f, (float)atof(argv[++i]));
+		else if (strcmp(argv[i], "--headless") == 0)
+			is_headless = true;
+		else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc)
+			script_path = argv[++i];
+		else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+			max_ticks = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+			job_workers = (unsigned int)atoi(argv[++i]);
+	}
+	const float tick_ms = 1000.f / tick_rate;
+
+	// Worker threads shared by the systems, e.g. texture decoding and the task graph below
+	job_system.start(job_workers);
+
 	// Global systems
 	WorldSystem world;
 	RenderSystem renderer;
 	PhysicsSystem physics;
 	AISystem ai;
 
+	// Assets are read from the pack when there is one, otherwise from their files
+	asset_pack.open(data_path() + "/assets.pack");
+
+	InputScript script;
+	if (script_path && !script.load(script_path))
+		return EXIT_FAILURE;
+
+	// A tick is a graph of tasks, added in the order they would run in one after the other
+	// Most of them are structural, so only AISystem::think, PhysicsSystem::move and
+	// WorldSystem::step_animations can run at the same time; the physics pair tests and the
+	// navigation grid are what spread over the JobSystem threads
+	TaskScheduler scheduler;
+	scheduler.add("store_previous_positions", STORE_PREVIOUS_POSITIONS_ACCESS, []() { store_previous_positions(); });
+	scheduler.add("WorldSystem::step", WorldSystem::STEP_ACCESS, [&]() { world.step(tick_ms); });
+	scheduler.add("AISystem::think", AISystem::THINK_ACCESS, [&]() { ai.think(tick_ms); });
+	scheduler.add("PhysicsSystem::move", PhysicsSystem::MOVE_ACCESS, [&]() { physics.move(tick_ms); });
+	scheduler.add("WorldSystem::step_animations", WorldSystem::STEP_ANIMATIONS_ACCESS, [&]() { world.step_animations(tick_ms); });
+	scheduler.add("AISystem::act", AISystem::ACT_ACCESS, [&]() { ai.act(tick_ms); });
+	scheduler.add("PhysicsSystem::detect_collisions", PhysicsSystem::DETECT_COLLISIONS_ACCESS, [&]() { physics.detect_collisions(); });
+	scheduler.add("PhysicsSystem::emit_collisions", PhysicsSystem::EMIT_COLLISIONS_ACCESS, [&]() { physics.emit_collisions(); });
+	scheduler.add("WorldSystem::handle_collisions", WorldSystem::HANDLE_COLLISIONS_ACCESS, [&]() { world.handle_collisions(tick_ms); });
+
+	if (is_headless) {
+		renderer.init(nullptr);
+		world.init(&renderer, &scheduler);
+		ai.init(&renderer);
+
+		auto start = Clock::now();
+		uint64_t ticks = 0;
+		double parallelism = 0.0;
+		while (!world.is_over() && ticks < max_ticks) {
+			script.play(world, ticks);
+			scheduler.run();
+			parallelism += scheduler.get_parallelism();
+			ticks++;
+		}
+		float elapsed_s =
+			(float)(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start)).count() / 1000000;
+		printf("Simulated %llu ticks (%.1f s of game time) in %.3f s, %.0f ticks per second\n",
+			(unsigned long long)ticks, ticks * tick_ms / 1000, elapsed_s, ticks / std::max(elapsed_s, 1e-6f));
+		// Scheduling overhead included, see TaskScheduler::get_parallelism()
+		printf("Average parallelism %.2f on %u threads, task time over tick time\n",
+			ticks > 0 ? parallelism / ticks : 1.0, job_system.get_thread_count());
+		write_profile();
+		return EXIT_SUCCESS;
+	}
+
 	// Initializing window
 	GLFWwindow* window = world.create_window();
 	if (!window) {
@@ -33,14 +144,17 @@ int main()
 
 	// initialize the main systems
 	renderer.init(window);
-	world.init(&renderer);
+	world.init(&renderer, &scheduler);
 	ai.init(&renderer);
 
-	// variable timestep loop
+	// fixed timestep loop
 	auto t = Clock::now();
+	float accumulator_ms = 0.f;
 	while (!world.is_over()) {
+#ifndef IOLS_HEADLESS
 		// Processes system messages, if this wasn't present the window would become unresponsive
 		glfwPollEvents();
+#endif
 
 		// Calculating elapsed times in milliseconds from the previous iteration
 		auto now = Clock::now();
@@ -48,13 +162,15 @@ int main()
 			(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
 		t = now;
 
-		world.step(elapsed_ms);
-		ai.step(elapsed_ms);
-		physics.step(elapsed_ms);
-		world.handle_collisions(elapsed_ms);
+		accumulator_ms = std::min(accumulator_ms + elapsed_ms, tick_ms * MAX_TICKS_PER_FRAME);
+		while (accumulator_ms >= tick_ms) {
+			scheduler.run();
+			accumulator_ms -= tick_ms;
+		}
 
-		renderer.draw();
+		renderer.draw(accumulator_ms / tick_ms);
 	}
 
+	write_profile();
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -2,8 +2,13 @@
 #include "physics_system.hpp"
 #include "world_init.hpp"
 #include "world_system.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
 
 const float PhysicsSystem::PATH_SPEED_MODIFIER = 30.f;
+const int PhysicsSystem::GRID_COLUMNS = (int)ceil(window_width_px / TILE_BB_WIDTH);
+const int PhysicsSystem::GRID_ROWS = (int)ceil(window_height_px / TILE_BB_HEIGHT);
+const size_t PhysicsSystem::PAIRS_PER_JOB = 256;
 
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Motion& motion)
@@ -29,9 +34,103 @@ bool PhysicsSystem::collides(const Motion& motion1, const Motion& motion2)
 	return false;
 }
 
+// Collects the pairs (i, j), i < j, of colliders that share a grid cell, in ascending order
+// collides() tests the distance against the larger of both radii, so the pair is found by
+// looking up the centre of the smaller body in the cells covered by the larger one. Bodies
+// outside of the window are clamped into the border cells, which keeps this conservative.
+void PhysicsSystem::find_candidate_pairs(const std::vector<std::pair<Entity, Motion*>>& colliders)
+{
+	const uint cell_count = (uint)(GRID_COLUMNS * GRID_ROWS);
+	auto column_of = [](float x) { return (uint)clamp((int)floor(x / TILE_BB_WIDTH), 0, GRID_COLUMNS - 1); };
+	auto row_of = [](float y) { return (uint)clamp((int)floor(y / TILE_BB_HEIGHT), 0, GRID_ROWS - 1); };
+
+	// Count the bodies per cell, then lay the cells out back to back (a counting sort)
+	cell_start.assign(cell_count + 1, 0);
+	body_cells.resize(colliders.size());
+	for (uint i = 0; i < colliders.size(); i++)
+	{
+		const Motion& motion = *colliders[i].second;
+		const vec2 bonding_box = get_bounding_box(motion) / 2.f;
+		const float radius = sqrt(dot(bonding_box, bonding_box));
+		const uint min_column = column_of(motion.position.x - radius), max_column = column_of(motion.position.x + radius);
+		const uint min_row = row_of(motion.position.y - radius), max_row = row_of(motion.position.y + radius);
+		body_cells[i] = { (min_row << 16) | min_column, (max_row << 16) | max_column };
+		for (uint row = min_row; row <= max_row; row++)
+			for (uint column = min_column; column <= max_column; column++)
+				cell_start[row * GRID_COLUMNS + column + 1]++;
+	}
+	for (uint cell = 0; cell < cell_count; cell++)
+		cell_start[cell + 1] += cell_start[cell];
+
+	cell_bodies.resize(cell_start[cell_count]);
+	cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+	for (uint i = 0; i < colliders.size(); i++)
+	{
+		const uint min_column = body_cells[i].first & 0xffff, max_column = body_cells[i].second & 0xffff;
+		const uint min_row = body_cells[i].first >> 16, max_row = body_cells[i].second >> 16;
+		for (uint row = min_row; row <= max_row; row++)
+			for (uint column = min_column; column <= max_column; column++)
+				cell_bodies[cell_fill[row * GRID_COLUMNS + column]++] = i;
+	}
+
+	// Pair every body with the bodies covering the cell of its centre
+	candidate_pairs.clear();
+	for (uint j = 0; j < colliders.size(); j++)
+	{
+		const vec2 position = colliders[j].second->position;
+		const uint cell = row_of(position.y) * GRID_COLUMNS + column_of(position.x);
+		for (uint k = cell_start[cell]; k < cell_start[cell + 1]; k++)
+		{
+			const uint i = cell_bodies[k];
+			if (i != j)
+				candidate_pairs.emplace_back(min(i, j), max(i, j));
+		}
+	}
+	std::sort(candidate_pairs.begin(), candidate_pairs.end());
+	candidate_pairs.erase(std::unique(candidate_pairs.begin(), candidate_pairs.end()), candidate_pairs.end());
+}
+
+void PhysicsSystem::collide_with_walls(const std::vector<std::pair<Entity, Motion*>>& colliders)
+{
+	for (uint t = 0; t < registry.tileMaps.size(); t++)
+	{
+		const TileMap& tile_map = registry.tileMaps.components[t];
+		Entity tile_map_entity = registry.tileMaps.entities[t];
+		Motion wall;
+		wall.scale = tile_map.tile_size;
+		const vec2 wall_bounding_box = get_bounding_box(wall) / 2.f;
+		const float wall_radius = sqrt(dot(wall_bounding_box, wall_bounding_box));
+
+		// Only the walls within the larger of both radii can collide, see collides()
+		for (const std::pair<Entity, Motion*>& collider : colliders)
+		{
+			Entity entity = collider.first;
+			const Motion& motion = *collider.second;
+			const vec2 bounding_box = get_bounding_box(motion) / 2.f;
+			const float radius = max(sqrt(dot(bounding_box, bounding_box)), wall_radius);
+			const int min_column = (int)floor((motion.position.x - radius) / tile_map.tile_size.x);
+			const int max_column = (int)floor((motion.position.x + radius) / tile_map.tile_size.x);
+			const int min_row = (int)floor((motion.position.y - radius) / tile_map.tile_size.y);
+			const int max_row = (int)floor((motion.position.y + radius) / tile_map.tile_size.y);
+			for (int row = min_row; row <= max_row; row++)
+			{
+				for (int column = min_column; column <= max_column; column++)
+				{
+					if (!tile_map.is_wall(column, row))
+						continue;
+					wall.position = tile_map.tile_center(column, row);
+					if (collides(motion, wall))
+						found_collisions.emplace_back(entity, tile_map_entity);
+				}
+			}
+		}
+	}
+}
+
 // Current enemy movement direction
-void PhysicsSystem::step(float elapsed_ms)
+void PhysicsSystem::move(float elapsed_ms)
 {
+	PROFILE_SCOPE("PhysicsSystem::move");
 	// Elapsed time in seconds
 	float step_seconds = elapsed_ms / 1000.f;
 
@@ -45,7 +144,7 @@ void PhysicsSystem::step(float elapsed_ms)
 	if (state.used_state == STATE_ID::IDLE)
 	{
 		auto& deadly_container = registry.subBosses;
-		for (uint i = 0; i < deadly_container.components.size(); i++)
+		for (uint i = 0; i < deadly_container.size(); i++)
 		{
 			Motion& enemy_motion = motion_registry.get(deadly_container.entities[i]);
 			enemy_motion.position.y += enemy_motion.velocity.y * step_seconds;
@@ -73,22 +172,21 @@ void PhysicsSystem::step(float elapsed_ms)
 	
 	if (player_motion.is_enroute)
 	{
-		vec2 direction_to_next = player_motion.path->next - player_motion.position;
-		double distance_to_next = WorldSystem::calc_heuristic(player_motion.path->next,player_motion.position);
+		vec2 direction_to_next = player_motion.path.next - player_motion.position;
+		double distance_to_next = WorldSystem::calc_heuristic(player_motion.path.next,player_motion.position);
 		
 		if (distance_to_next <= WorldSystem::GRANULARITY)
 		{
-			vec2 node = player_motion.path->next;
-			if (player_motion.path->path_stack.empty())
+			if (player_motion.path.path_stack.empty())
 			{
 				player_motion.is_enroute = false;
 				direction_to_next = { 0,0 };
 			}
 			else 
 			{
-				player_motion.path->next = player_motion.path->path_stack.top();
-				player_motion.path->path_stack.pop();
-				direction_to_next = player_motion.path->next - player_motion.position;
+				player_motion.path.next = player_motion.path.path_stack.back();
+				player_motion.path.path_stack.pop_back();
+				direction_to_next = player_motion.path.next - player_motion.position;
 			}		
 		}
 		player_motion.velocity = PATH_SPEED_MODIFIER * direction_to_next;
@@ -118,57 +216,59 @@ void PhysicsSystem::step(float elapsed_ms)
 		player_motion.position.y = window_height_px - player_radius;
 		player_motion.velocity.y = 0.f;
 	}
+}
+
+void PhysicsSystem::detect_collisions()
+{
+	PROFILE_SCOPE("PhysicsSystem::detect_collisions");
+	found_collisions.clear();
 
 	// Check for collisions between all moving entities
-    ComponentContainer<Motion> &motion_container = registry.motions;
-	for (uint i = 0; i < motion_container.components.size(); i++)
+	// Traversable entities never collide, so they are filtered out once instead of per pair
+	ComponentContainer<Motion> &motion_container = registry.motions;
+	std::vector<std::pair<Entity, Motion*>> colliders;
+	colliders.reserve(motion_container.size());
+	registry.view<Motion>(exclude<Traversable>)
+		.each([&](Entity entity, Motion& motion) { colliders.emplace_back(entity, &motion); });
+
+	// Only nearby bodies are compared; the pairs come in the same (i,j) order as comparing all of them
+	// The pairs are tested as jobs, then the colliding ones are collected in that order
+	find_candidate_pairs(colliders);
+	pair_collides.resize(candidate_pairs.size());
+	job_system.parallel_for(0, candidate_pairs.size(), PAIRS_PER_JOB, [&](size_t first, size_t last) {
+		for (size_t p = first; p < last; p++)
+			pair_collides[p] = collides(*colliders[candidate_pairs[p].first].second, *colliders[candidate_pairs[p].second].second);
+	});
+	for (size_t p = 0; p < candidate_pairs.size(); p++)
 	{
-		Entity entity_i = motion_container.entities[i];
-		// Skip entities that are traversable
-		if (registry.traversables.has(entity_i))
-			continue;
-
-		Motion& motion_i = motion_container.components[i];
-		// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-		for (uint j = i+1; j < motion_container.components.size(); j++)
-		{
-			Entity entity_j = motion_container.entities[j];
-			// Skip entities that are traversable
-			if (registry.traversables.has(entity_j))
-				continue;
+		if (pair_collides[p])
+			found_collisions.emplace_back(colliders[candidate_pairs[p].first].first, colliders[candidate_pairs[p].second].first);
+	}
+	collide_with_walls(colliders);
+}
 
-			Motion& motion_j = motion_container.components[j];
-			if (collides(motion_i, motion_j))
-			{
-				// Create a collisions event
-				// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-				registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-			}
-		}
+void PhysicsSystem::emit_collisions()
+{
+	PROFILE_SCOPE("PhysicsSystem::emit_collisions");
+	for (std::pair<Entity, Entity>& collision : found_collisions)
+	{
+		// Create a collisions event
+		// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+		registry.collisions.emplace_with_duplicates(collision.first, collision.second);
+		registry.collisions.emplace_with_duplicates(collision.second, collision.first);
 	}
 
 	// debugging of bounding boxes
 	if (debugging.in_debug_mode)
 	{
-		uint size_before_adding_new = (uint)motion_container.components.size();
-		for (uint i = 0; i < size_before_adding_new; i++)
+		const vec3 red = { 0.8f, 0.1f, 0.1f };
+		for (const Motion& motion_i : registry.motions.components)
 		{
-			Motion& motion_i = motion_container.components[i];
-			Entity entity_i = motion_container.entities[i];
-
-			// don't draw debugging visuals around debug lines
-			if (registry.debugComponents.has(entity_i))
-				continue;
-
-			// visualize the radius with two axis-aligned lines
+			// visualize the bounding box and the radius used by collides()
 			const vec2 bonding_box = get_bounding_box(motion_i);
 			float radius = sqrt(dot(bonding_box/2.f, bonding_box/2.f));
-			vec2 line_scale1 = { motion_i.scale.x / 10, 2*radius };
-			vec2 line_scale2 = { 2*radius, motion_i.scale.x / 10};
-			vec2 position = motion_i.position;
-			Entity line1 = createLine(motion_i.position, line_scale1);
-			Entity line2 = createLine(motion_i.position, line_scale2);
+			debug_draw.box(motion_i.position, bonding_box, red);
+			debug_draw.circle(motion_i.position, radius, red);
 		}
 	}
 }
\ No newline at end of file
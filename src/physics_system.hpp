@@ -4,14 +4,48 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "task_scheduler.hpp"
 
 // A simple physics system that moves rigid bodies and checks for collision
+// A step is three tasks, each with the registry access it declares for the TaskScheduler
 class PhysicsSystem
 {
 public:
-	void step(float elapsed_ms);
+	// Moves the player and the enemies
+	void move(float elapsed_ms);
+	static constexpr TaskAccess MOVE_ACCESS = {
+		GameRegistry::mask<ScreenState, SubBoss, Player>(), GameRegistry::mask<Motion>() };
+
+	// Finds the colliding bodies, without adding the collisions to the registry yet
+	void detect_collisions();
+	static constexpr TaskAccess DETECT_COLLISIONS_ACCESS = {
+		GameRegistry::mask<Motion, Traversable, TileMap>(), 0 };
+
+	// Adds the collisions found by detect_collisions() to the registry
+	void emit_collisions();
+	static constexpr TaskAccess EMIT_COLLISIONS_ACCESS = STRUCTURAL_ACCESS;
+
 	static bool collides(const Motion& motion1, const Motion& motion2);
 private:
 	//modifies the speed at which the player follows the path.
 	static const float PATH_SPEED_MODIFIER; 
+
+	// Uniform grid broadphase over the window, one cell per tile. Bodies are bucketed into all
+	// cells their bounding circle overlaps, so only bodies sharing a cell are tested in pairs.
+	static const int GRID_COLUMNS;
+	static const int GRID_ROWS;
+	void find_candidate_pairs(const std::vector<std::pair<Entity, Motion*>>& colliders);
+
+	// Collisions with the wall tiles of the tile map, each wall collides like a tile sized body
+	void collide_with_walls(const std::vector<std::pair<Entity, Motion*>>& colliders);
+
+	// Kept between steps so the broadphase does not allocate once warmed up
+	std::vector<uint> cell_start; // first body of each cell in cell_bodies, plus an end marker
+	std::vector<uint> cell_fill; // next free position of each cell while filling cell_bodies
+	std::vector<uint> cell_bodies;
+	std::vector<std::pair<uint, uint>> body_cells; // first and last cell (column, row packed) per body
+	std::vector<std::pair<uint, uint>> candidate_pairs;
+	std::vector<char> pair_collides; // per candidate pair, written by the jobs testing them
+	static const size_t PAIRS_PER_JOB;
+	std::vector<std::pair<Entity, Entity>> found_collisions; // by detect_collisions(), for emit_collisions()
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+// internal
+#include "profiler.hpp"
+
+#ifdef IOLS_PROFILE
+
+// stlib
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+Profiler profiler;
+
+int64_t Profiler::now_since_boot()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t Profiler::now() const
+{
+	return now_since_boot() - epoch;
+}
+
+Profiler::ThreadBuffer& Profiler::thread_buffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (buffer == nullptr)
+	{
+		std::unique_ptr<ThreadBuffer> created = std::make_unique<ThreadBuffer>();
+		created->zones.resize(RING_CAPACITY);
+		buffer = created.get();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		buffer->thread_id = (uint32_t)buffers.size() + 1;
+		buffers.push_back(std::move(created));
+	}
+	return *buffer;
+}
+
+void Profiler::record(const char* name, int64_t start_ns, int64_t end_ns)
+{
+	ThreadBuffer& buffer = thread_buffer();
+	// Only this thread writes the buffer, the release publishes the zone to write_trace()
+	uint64_t i = buffer.recorded.load(std::memory_order_relaxed);
+	buffer.zones[i % RING_CAPACITY] = { name, start_ns, end_ns };
+	buffer.recorded.store(i + 1, std::memory_order_release);
+}
+
+bool Profiler::write_trace(const std::string& path)
+{
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Failed to write the trace %s\n", path.c_str());
+		return false;
+	}
+
+	// Complete events ("X") with microsecond timestamps, see the Trace Event Format
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t zone_count = 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	const char* separator = "\n";
+	for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+	{
+		const uint64_t recorded = buffer->recorded.load(std::memory_order_acquire);
+		const uint64_t first = recorded > RING_CAPACITY ? recorded - RING_CAPACITY : 0;
+		for (uint64_t i = first; i < recorded; i++)
+		{
+			const Zone& zone = buffer->zones[i % RING_CAPACITY];
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				separator, zone.name, buffer->thread_id,
+				zone.start_ns / 1000.0, (zone.end_ns - zone.start_ns) / 1000.0);
+			separator = ",\n";
+		}
+		zone_count += (size_t)(recorded - first);
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	printf("Wrote %zu zones of %zu threads to %s\n", zone_count, buffers.size(), path.c_str());
+	return true;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+// Profiler
+// PROFILE_SCOPE("name") records a zone from where it is declared to the end of its scope: its
+// name, start and end on a monotonic clock and the thread it ran on. Each thread records into
+// a ring buffer of its own, which keeps the last RING_CAPACITY zones, so recording takes no
+// lock. write_trace() saves the zones of all threads as Chrome trace events, viewable in
+// chrome://tracing or Perfetto.
+//
+// All of it is compiled out unless IOLS_PROFILE is defined (cmake -DIOLS_PROFILE=ON): then
+// PROFILE_SCOPE expands to nothing and the profiler does not exist.
+#ifdef IOLS_PROFILE
+
+// stlib
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Profiler
+{
+public:
+	static const size_t RING_CAPACITY = 1 << 16; // zones kept per thread
+
+	// Nanoseconds on a monotonic clock since the profiler was created
+	int64_t now() const;
+
+	// name must outlive the profiler, e.g. a string literal
+	void record(const char* name, int64_t start_ns, int64_t end_ns);
+
+	// Writes the recorded zones as Chrome trace_event JSON, returns false if the file cannot be
+	// written. No other thread may record zones meanwhile: once a ring is full, a new zone
+	// overwrites the slot that is being read. Call it between ticks, when the workers of the
+	// JobSystem are idle and TaskScheduler::run() has synchronized with them, or at exit.
+	bool write_trace(const std::string& path);
+
+private:
+	struct Zone {
+		const char* name;
+		int64_t start_ns, end_ns;
+	};
+	struct ThreadBuffer {
+		uint32_t thread_id;
+		std::vector<Zone> zones; // RING_CAPACITY, zone i is at i % RING_CAPACITY
+		std::atomic<uint64_t> recorded{ 0 };
+	};
+
+	// The buffer of the calling thread, created on its first zone
+	// Buffers outlive their threads, a trace includes threads that have ended
+	ThreadBuffer& thread_buffer();
+
+	std::mutex mutex; // guards buffers
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	const int64_t epoch = now_since_boot();
+	static int64_t now_since_boot();
+};
+
+extern Profiler profiler;
+
+// Records the zone from its construction to its destruction, see PROFILE_SCOPE
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name_arg) : name(name_arg), start_ns(profiler.now()) {}
+	~ProfileZone() { profiler.record(name, start_ns, profiler.now()); }
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name;
+	int64_t start_ns;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif
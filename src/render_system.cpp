@@ -2,169 +2,389 @@
 #include "render_system.hpp"
 #include <SDL.h>
 
+#include "profiler.hpp"
 #include "tiny_ecs_registry.hpp"
 
+// Nothing is known to be bound, the next call of each kind is issued
+void GlStateCache::invalidate()
+{
+	program = vao = array_buffer = framebuffer = active_unit = blend = depth_test = ~0u;
+	for (GLuint& texture : textures)
+		texture = ~0u;
+}
+
+bool GlStateCache::redundant(GLuint& shadow, GLuint value)
+{
+	if (shadow == value)
+	{
+		elided++;
+		return true;
+	}
+	shadow = value;
+	issued++;
+	return false;
+}
+
+void GlStateCache::useProgram(GLuint value)
+{
+	if (!redundant(program, value))
+		glUseProgram(value);
+}
+
+void GlStateCache::bindVertexArray(GLuint value)
+{
+	if (!redundant(vao, value))
+		glBindVertexArray(value);
+}
+
+void GlStateCache::bindArrayBuffer(GLuint value)
+{
+	if (!redundant(array_buffer, value))
+		glBindBuffer(GL_ARRAY_BUFFER, value);
+}
+
+void GlStateCache::bindFramebuffer(GLuint value)
+{
+	if (!redundant(framebuffer, value))
+		glBindFramebuffer(GL_FRAMEBUFFER, value);
+}
+
+void GlStateCache::bindTexture(GLuint unit, GLuint texture)
+{
+	assert(unit < TEXTURE_UNITS);
+	if (textures[unit] == texture)
+	{
+		elided++;
+		return;
+	}
+	if (!redundant(active_unit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+	redundant(textures[unit], texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GlStateCache::setBlend(bool enabled)
+{
+	if (!redundant(blend, enabled))
+		enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+}
+
+void GlStateCache::setDepthTest(bool enabled)
+{
+	if (!redundant(depth_test, enabled))
+		enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+}
+
+vec2 RenderSystem::interpolatedPosition(const Motion& motion) const
+{
+	vec2 moved = motion.position - motion.previous_position;
+	if (dot(moved, moved) > MAX_INTERPOLATION_DISTANCE * MAX_INTERPOLATION_DISTANCE)
+		return motion.position;
+	return motion.previous_position + moved * interpolation;
+}
+
 void RenderSystem::drawTexturedMesh(Entity entity,
+									const Motion &motion,
+									const RenderRequest &render_request,
 									const mat3 &projection)
 {
-	Motion &motion = registry.motions.get(entity);
 	// Incrementally updates transformation matrix
 	Transform transform;
-	transform.translate(motion.position);
+	transform.translate(interpolatedPosition(motion));
 	transform.scale(motion.scale);
 
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
-
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations& locations = effect_locations[used_effect_enum];
 
 	// Setting shaders
-	glUseProgram(program);
+	gl_state.useProgram(program);
 	gl_has_errors();
 
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
 
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	// Setting the vertex layout, vertex and index buffers
+	gl_state.bindVertexArray(vertex_arrays[(GLuint)render_request.used_geometry]);
 	gl_has_errors();
 
-	// Input data location as in the vertex buffer
-	if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED || 
-		render_request.used_effect == EFFECT_ASSET_ID::ANIMATED ||
-		render_request.used_effect == EFFECT_ASSET_ID::CARD)
+	// Binding the textures and uniforms specific to the effect
+	if (samplesTexture(render_request.used_effect))
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
+		// Enabling and binding the atlas page of the texture to slot 0
+		GLuint texture_id = pageHandle(render_request.used_texture);
 
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(TexturedVertex), (void *)0);
+		gl_state.bindTexture(0, texture_id);
 		gl_has_errors();
 
-		glEnableVertexAttribArray(in_texcoord_loc);
-		glVertexAttribPointer(
-			in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-			(void *)sizeof(
-				vec3)); // note the stride to skip the preceeding vertex position
-
-		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
-		gl_has_errors();
-
-		assert(registry.renderRequests.has(entity));
-		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
-
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		gl_has_errors();
+		// The atlas rectangles of the samplers
+		vec4 texrects[4] = { texture_rects[(GLuint)render_request.used_texture] };
 
 		if (render_request.used_effect == EFFECT_ASSET_ID::ANIMATED)
 		{
 			int current_frame_uloc = registry.animations.get(entity).current_frame;
 			int num_frames_uloc = registry.animations.get(entity).num_frames;
 
-			glUniform1i(glGetUniformLocation(program, "current_frame"), current_frame_uloc);
-			glUniform1i(glGetUniformLocation(program, "num_frames"), num_frames_uloc);
+			glUniform1i(locations.current_frame, current_frame_uloc);
+			glUniform1i(locations.num_frames, num_frames_uloc);
 			gl_has_errors();
 		}
 		else if (render_request.used_effect == EFFECT_ASSET_ID::CARD)
 		{
-			// Enabling and binding card frame texture to slot 1
-			glActiveTexture(GL_TEXTURE1);
+			// Enabling and binding card frame, health and damage textures to slots 1 to 3
+			// These are the same for all cards, so after the first card they are skipped
+			const TEXTURE_ASSET_ID card_textures[] = {
+				TEXTURE_ASSET_ID::CARD_FRAME, TEXTURE_ASSET_ID::CARD_HEALTH, TEXTURE_ASSET_ID::CARD_DAMAGE };
+			for (GLuint slot = 1; slot < 4; slot++)
+			{
+				gl_state.bindTexture(slot, pageHandle(card_textures[slot - 1]));
+				texrects[slot] = texture_rects[(GLuint)card_textures[slot - 1]];
+			}
 			gl_has_errors();
 
-			assert(registry.renderRequests.has(entity));
-			texture_id = texture_gl_handles[(GLuint)TEXTURE_ASSET_ID::CARD_FRAME];
+			// The sampler uniforms are bound to these slots in initializeGlEffects
 
-			glBindTexture(GL_TEXTURE_2D, texture_id);
-			gl_has_errors();
+			// Binding health and damage outputs to uniforms
+			int current_health_uloc = (int)registry.healthComponents.get(entity).current_health;
+			int max_health_damage_uloc = (int)registry.healthComponents.get(entity).max_health;
+			int current_damage_uloc = (int)registry.damageComponents.get(entity).damage_output;
 
-			// Enabling and binding health texture to slot 2
-			glActiveTexture(GL_TEXTURE2);
+			glUniform1i(locations.current_health, current_health_uloc);
+			glUniform1i(locations.max_health_damage, max_health_damage_uloc);
+			glUniform1i(locations.current_damage, current_damage_uloc);
 			gl_has_errors();
+		}
 
-			texture_id = texture_gl_handles[(GLuint)TEXTURE_ASSET_ID::CARD_HEALTH];
-			glBindTexture(GL_TEXTURE_2D, texture_id);
-			gl_has_errors();
+		// Only the card effect samples more than one texture
+		const GLsizei texrect_count = render_request.used_effect == EFFECT_ASSET_ID::CARD ? 4 : 1;
+		glUniform4fv(locations.texrect, texrect_count, (float *)texrects);
+		gl_has_errors();
+	}
+	else if (render_request.used_effect != EFFECT_ASSET_ID::EGG)
+	{
+		assert(false && "Type of render request not supported");
+	}
 
-			// Enabling and binding damage texture to slot 3
-			glActiveTexture(GL_TEXTURE3);
-			gl_has_errors();
 
-			texture_id = texture_gl_handles[(GLuint)TEXTURE_ASSET_ID::CARD_DAMAGE];
-			glBindTexture(GL_TEXTURE_2D, texture_id);
-			gl_has_errors();
+	// Setting uniform values
+	GLint color_uloc = locations.fcolor;
+	const vec3* custom_color = registry.colors.find(entity);
+	const vec3 color = custom_color ? *custom_color : vec3(1);
+	glUniform3fv(color_uloc, 1, (float *)&color);
+	gl_has_errors();
 
-			// Binding slots to uniforms
-			glUniform1i(glGetUniformLocation(program, "sampler0"), 0);
-			glUniform1i(glGetUniformLocation(program, "sampler1"), 1);
-			glUniform1i(glGetUniformLocation(program, "sampler2"), 2);
-			glUniform1i(glGetUniformLocation(program, "sampler3"), 3);
-			gl_has_errors();
+	// Number of indices in the index buffer, recorded when it was filled
+	GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
+	// GLsizei num_triangles = num_indices / 3;
 
-			// Binding health and damage outputs to uniforms
-			int current_health_uloc = (int)registry.healthComponents.get(entity).current_health;
-			int max_health_damage_uloc = (int)registry.healthComponents.get(entity).max_health;
-			int current_damage_uloc = (int)registry.damageComponents.get(entity).damage_output;
+	glUniformMatrix3fv(locations.transform, 1, GL_FALSE, (float *)&transform.mat);
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float *)&projection);
+	gl_has_errors();
+	// Drawing of num_indices/3 triangles specified in the index buffer
+	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	draw_calls++;
+	gl_has_errors();
+}
 
-			glUniform1i(glGetUniformLocation(program, "current_health"), current_health_uloc);
-			glUniform1i(glGetUniformLocation(program, "max_health_damage"), max_health_damage_uloc);
-			glUniform1i(glGetUniformLocation(program, "current_damage"), current_damage_uloc);
-			gl_has_errors();
+bool RenderSystem::samplesTexture(EFFECT_ASSET_ID effect)
+{
+	return effect == EFFECT_ASSET_ID::TEXTURED ||
+		effect == EFFECT_ASSET_ID::ANIMATED ||
+		effect == EFFECT_ASSET_ID::CARD;
+}
+
+uint64_t RenderSystem::sortKey(const RenderRequest& render_request, uint32_t position) const
+{
+	// Requests that sample no texture all go on page 0
+	GLuint page = 0;
+	if (samplesTexture(render_request.used_effect))
+	{
+		assert(render_request.used_texture != TEXTURE_ASSET_ID::TEXTURE_COUNT);
+		page = texture_pages[(GLuint)render_request.used_texture];
+	}
+	return ((uint64_t)render_request.used_layer << 56) |
+		((uint64_t)render_request.used_effect << 48) |
+		((uint64_t)page << 32) |
+		position;
+}
+
+// Sorts the keys in ascending order, one counting pass per byte starting from the lowest
+// Passes over a byte that is the same in all keys (e.g. the layer on a single layer screen,
+// or the upper bytes of the position) are skipped.
+static void radix_sort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch)
+{
+	scratch.resize(keys.size());
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = {};
+		for (uint64_t key : keys)
+			counts[(key >> shift) & 0xff]++;
+		if (keys.empty() || counts[(keys[0] >> shift) & 0xff] == keys.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			const size_t bucket_size = count;
+			count = offset;
+			offset += bucket_size;
 		}
+		for (uint64_t key : keys)
+			scratch[counts[(key >> shift) & 0xff]++] = key;
+		keys.swap(scratch);
 	}
-	else if (render_request.used_effect == EFFECT_ASSET_ID::EGG)
+}
+
+// Textured and animated sprites only differ in their texture coordinates, so they can share
+// the instanced sprite effect
+bool RenderSystem::isInstancedSprite(const RenderRequest& render_request)
+{
+	return render_request.used_geometry == GEOMETRY_BUFFER_ID::SPRITE &&
+		(render_request.used_effect == EFFECT_ASSET_ID::TEXTURED ||
+		 render_request.used_effect == EFFECT_ASSET_ID::ANIMATED);
+}
+
+void RenderSystem::addSpriteInstance(Entity entity, const Motion& motion, const RenderRequest& render_request)
+{
+	SpriteInstance instance;
+
+	Transform transform;
+	transform.translate(interpolatedPosition(motion));
+	transform.scale(motion.scale);
+	instance.transform = transform.mat;
+
+	// Animated sprites show one frame of their sprite sheet, see animated.fs.glsl
+	vec4 frame = { 0.f, 0.f, 1.f, 1.f };
+	if (render_request.used_effect == EFFECT_ASSET_ID::ANIMATED)
 	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
+		const Animation& animation = registry.animations.get(entity);
+		frame.x = (float)animation.current_frame / animation.num_frames;
+		frame.z = 1.f / animation.num_frames;
+	}
 
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)0);
-		gl_has_errors();
+	// The frame in texture coordinates, moved to where the texture is in its atlas page
+	const vec4& rect = texture_rects[(GLuint)render_request.used_texture];
+	instance.texrect = {
+		rect.x + frame.x * rect.z, rect.y + frame.y * rect.w,
+		frame.z * rect.z, frame.w * rect.w };
 
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
+	const vec3* custom_color = registry.colors.find(entity);
+	instance.color = custom_color ? *custom_color : vec3(1);
+
+	sprite_instances.push_back(instance);
+}
+
+// Draws the instances [first_instance, first_instance + instance_count) of the frame
+void RenderSystem::drawSpriteBatch(const DrawItem& batch, const mat3& projection)
+{
+	const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::SPRITE];
+	const EffectLocations& locations = effect_locations[(GLuint)EFFECT_ASSET_ID::SPRITE];
+	gl_state.useProgram(program);
+	gl_has_errors();
+
+	// The sprite quad plus the instance data, starting at the first instance of the batch
+	gl_state.bindVertexArray(sprite_instance_vao);
+	gl_state.bindArrayBuffer(sprite_instance_buffer);
+	const size_t base = batch.first_instance * sizeof(SpriteInstance);
+	const GLuint transform_loc = (GLuint)ATTRIBUTE_LOCATION::TRANSFORM;
+	for (GLuint column = 0; column < 3; column++)
+		glVertexAttribPointer(transform_loc + column, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+							  (void *)(base + offsetof(SpriteInstance, transform) + column * sizeof(vec3)));
+	glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::TEXRECT, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+						  (void *)(base + offsetof(SpriteInstance, texrect)));
+	glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+						  (void *)(base + offsetof(SpriteInstance, color)));
+	gl_has_errors();
+
+	// Enabling and binding texture to slot 0
+	gl_state.bindTexture(0, batch.texture);
+	gl_has_errors();
+
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float *)&projection);
+	gl_has_errors();
+
+	glDrawElementsInstanced(GL_TRIANGLES, index_counts[(GLuint)GEOMETRY_BUFFER_ID::SPRITE], GL_UNSIGNED_SHORT, nullptr, batch.instance_count);
+	draw_calls++;
+	gl_has_errors();
+}
+
+// Draws all tiles with one quad over the whole map, the tilemap effect looks up the tile of each
+// fragment in the tile texture and samples the path or wall texture
+void RenderSystem::drawTileMap(Entity entity, const mat3& projection)
+{
+	TileMap& tile_map = registry.tileMaps.get(entity);
+	const GLuint program = effects[(GLuint)EFFECT_ASSET_ID::TILEMAP];
+	const EffectLocations& locations = effect_locations[(GLuint)EFFECT_ASSET_ID::TILEMAP];
+	gl_state.useProgram(program);
+	gl_state.bindVertexArray(vertex_arrays[(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
+	gl_has_errors();
+
+	// Enabling and binding the path and wall textures to slots 0 and 1, the tiles to slot 2
+	gl_state.bindTexture(0, pageHandle(tile_map.path_texture));
+	gl_state.bindTexture(1, pageHandle(tile_map.wall_texture));
+	if (tile_texture == 0)
+	{
+		glGenTextures(1, &tile_texture);
+		gl_state.bindTexture(2, tile_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	}
-	else
+	gl_state.bindTexture(2, tile_texture);
+	gl_has_errors();
+
+	// A new map is uploaded once, the rows of the grid are one byte per tile
+	if (!tile_map.is_uploaded)
 	{
-		assert(false && "Type of render request not supported");
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, tile_map.columns, tile_map.rows, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tile_map.walls.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		tile_map.is_uploaded = true;
+		gl_has_errors();
 	}
 
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
-	glUniform3fv(color_uloc, 1, (float *)&color);
+	const vec4 texrects[2] = {
+		texture_rects[(GLuint)tile_map.path_texture], texture_rects[(GLuint)tile_map.wall_texture] };
+	glUniform4fv(locations.texrect, 2, (float *)texrects);
+
+	// The sprite quad stretched over the map
+	const vec2 size = vec2(tile_map.columns, tile_map.rows) * tile_map.tile_size;
+	Transform transform;
+	transform.translate(size / 2.f);
+	transform.scale(size);
+	glUniformMatrix3fv(locations.transform, 1, GL_FALSE, (float *)&transform.mat);
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
 
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+	glDrawElements(GL_TRIANGLES, index_counts[(GLuint)GEOMETRY_BUFFER_ID::SPRITE], GL_UNSIGNED_SHORT, nullptr);
+	draw_calls++;
 	gl_has_errors();
+}
 
-	GLsizei num_indices = size / sizeof(uint16_t);
-	// GLsizei num_triangles = num_indices / 3;
+// Draws all lines of DebugDraw on top of the frame in one draw call
+void RenderSystem::drawDebugLines(const mat3& projection)
+{
+	if (debug_draw.vertices.empty())
+		return;
 
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
+	gl_state.useProgram(effects[(GLuint)EFFECT_ASSET_ID::DEBUG_LINES]);
+	gl_state.bindVertexArray(debug_vao);
+	gl_state.bindArrayBuffer(debug_vertex_buffer);
 	gl_has_errors();
-	// Drawing of num_indices/3 triangles specified in the index buffer
-	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+
+	// Orphan the buffer so the driver does not wait on the last frame
+	const size_t count = debug_draw.vertices.size();
+	if (count > debug_vertex_capacity)
+		debug_vertex_capacity = max(count, 2 * debug_vertex_capacity);
+	glBufferData(GL_ARRAY_BUFFER, debug_vertex_capacity * sizeof(ColoredVertex), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ColoredVertex), debug_draw.vertices.data());
+	gl_has_errors();
+
+	const EffectLocations& locations = effect_locations[(GLuint)EFFECT_ASSET_ID::DEBUG_LINES];
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float *)&projection);
+	glDrawArrays(GL_LINES, 0, (GLsizei)count);
+	draw_calls++;
 	gl_has_errors();
 }
 
@@ -174,12 +394,12 @@ void RenderSystem::drawToScreen()
 {
 	// Setting shaders
 	// get the wind texture, sprite mesh, and program
-	glUseProgram(effects[(GLuint)EFFECT_ASSET_ID::WIND]);
+	gl_state.useProgram(effects[(GLuint)EFFECT_ASSET_ID::WIND]);
 	gl_has_errors();
 	// Clearing backbuffer
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl_state.bindFramebuffer(0);
 	glViewport(0, 0, w, h);
 	glDepthRange(0, 10);
 	glClearColor(1.f, 0, 0, 1.0);
@@ -187,55 +407,48 @@ void RenderSystem::drawToScreen()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	gl_has_errors();
 	// Enabling alpha channel for textures
-	glDisable(GL_BLEND);
+	gl_state.setBlend(false);
 	// glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_DEPTH_TEST);
+	gl_state.setDepthTest(false);
 
 	// Draw the screen texture on the quad geometry
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
-	glBindBuffer(
-		GL_ELEMENT_ARRAY_BUFFER,
-		index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]); // Note, GL_ELEMENT_ARRAY_BUFFER associates
-																	 // indices to the bound GL_ARRAY_BUFFER
+	gl_state.bindVertexArray(vertex_arrays[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
 	gl_has_errors();
-	const GLuint wind_program = effects[(GLuint)EFFECT_ASSET_ID::WIND];
+	const EffectLocations& wind_locations = effect_locations[(GLuint)EFFECT_ASSET_ID::WIND];
 	// Set clock
-	GLuint time_uloc = glGetUniformLocation(wind_program, "time");
-	GLuint dead_timer_uloc = glGetUniformLocation(wind_program, "darken_screen_factor");
+	GLint time_uloc = wind_locations.time;
+	GLint dead_timer_uloc = wind_locations.darken_screen_factor;
 	glUniform1f(time_uloc, (float)(glfwGetTime() * 10.0f));
 	ScreenState &screen = registry.screenStates.get(screen_state_entity);
 	glUniform1f(dead_timer_uloc, screen.darken_screen_factor);
 	gl_has_errors();
-	// Set the vertex position and vertex texture coordinates (both stored in the
-	// same VBO)
-	GLint in_position_loc = glGetAttribLocation(wind_program, "in_position");
-	glEnableVertexAttribArray(in_position_loc);
-	glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void *)0);
-	gl_has_errors();
 
 	// Bind our texture in Texture Unit 0
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
+	gl_state.bindTexture(0, off_screen_render_buffer_color);
 	gl_has_errors();
 	// Draw
 	glDrawElements(
 		GL_TRIANGLES, 3, GL_UNSIGNED_SHORT,
 		nullptr); // one triangle = 3 vertices; nullptr indicates that there is
 				  // no offset from the bound index buffer
+	draw_calls++;
 	gl_has_errors();
 }
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
-void RenderSystem::draw()
+void RenderSystem::draw(float alpha)
 {
+	PROFILE_SCOPE("RenderSystem::draw");
+	interpolation = alpha;
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+	draw_calls = 0;
+	gl_state.resetCounters();
 
 	// First render to the custom framebuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+	gl_state.bindFramebuffer(frame_buffer);
 	gl_has_errors();
 	// Clearing backbuffer
 	glViewport(0, 0, w, h);
@@ -243,22 +456,69 @@ void RenderSystem::draw()
 	glClearColor(0, 0, 0, 1.0);
 	glClearDepth(10.f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glEnable(GL_BLEND);
+	gl_state.setBlend(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_DEPTH_TEST); // native OpenGL does not work with a depth buffer
+	gl_state.setDepthTest(false); // native OpenGL does not work with a depth buffer
 							  // and alpha blending, one would have to sort
 							  // sprites back to front
 	gl_has_errors();
 	mat3 projection_2D = createProjectionMatrix();
-	// Draw all textured meshes that have a position and size component
-	for (Entity entity : registry.renderRequests.entities)
+	// Queue all textured meshes that have a position and size component, and sort them into
+	// draw order, see sortKey
+	render_queue.clear();
+	render_keys.clear();
+	registry.view<RenderRequest, Motion>()
+		.use(registry.renderRequests)
+		.each([&](Entity entity, RenderRequest& render_request, Motion& motion) {
+			render_keys.push_back(sortKey(render_request, (uint32_t)render_queue.size()));
+			render_queue.push_back({ entity, &motion, &render_request });
+		});
+	registry.view<RenderRequest, TileMap>()
+		.each([&](Entity entity, RenderRequest& render_request, TileMap&) {
+			render_keys.push_back(sortKey(render_request, (uint32_t)render_queue.size()));
+			render_queue.push_back({ entity, nullptr, &render_request });
+		});
+	radix_sort(render_keys, render_keys_scratch);
+
+	// Runs of sprites on the same atlas page are collected into batches first, so that the
+	// instance data of the whole frame is uploaded at once
+	sprite_instances.clear();
+	draw_items.clear();
+	for (uint64_t key : render_keys)
 	{
-		if (!registry.motions.has(entity))
+		const QueuedRequest& queued = render_queue[(uint32_t)key];
+		const RenderRequest& render_request = *queued.render_request;
+		if (!isInstancedSprite(render_request))
+		{
+			draw_items.push_back({ queued.entity, queued.motion, &render_request, 0, 0, 0 });
 			continue;
-		// Note, its not very efficient to access elements indirectly via the entity
-		// albeit iterating through all Sprites in sequence. A good point to optimize
-		drawTexturedMesh(entity, projection_2D);
+		}
+
+		const GLuint texture = pageHandle(render_request.used_texture);
+		if (draw_items.empty() || draw_items.back().render_request != nullptr || draw_items.back().texture != texture)
+			draw_items.push_back({ queued.entity, queued.motion, nullptr, texture, (GLuint)sprite_instances.size(), 0 });
+		addSpriteInstance(queued.entity, *queued.motion, render_request);
+		draw_items.back().instance_count++;
+	}
+
+	// Stream the instances, the buffer is orphaned so the driver does not wait on the last frame
+	gl_state.bindArrayBuffer(sprite_instance_buffer);
+	if (sprite_instances.size() > sprite_instance_capacity)
+		sprite_instance_capacity = max(sprite_instances.size(), 2 * sprite_instance_capacity);
+	glBufferData(GL_ARRAY_BUFFER, sprite_instance_capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sprite_instances.size() * sizeof(SpriteInstance), sprite_instances.data());
+	gl_has_errors();
+
+	for (const DrawItem& item : draw_items)
+	{
+		if (!item.render_request)
+			drawSpriteBatch(item, projection_2D);
+		else if (!item.motion)
+			drawTileMap(item.entity, projection_2D);
+		else
+			drawTexturedMesh(item.entity, *item.motion, *item.render_request, projection_2D);
 	}
+	drawDebugLines(projection_2D);
 
 	// Truely render to the screen
 	drawToScreen();
@@ -7,6 +7,43 @@
 #include "components.hpp"
 #include "tiny_ecs.hpp"
 
+// Shadows the GL state the draw loop binds, so that binding what is already bound is skipped
+// All of these binds in the draw loop go through the cache; after binding GL state directly,
+// e.g. while initializing, invalidate() it.
+class GlStateCache
+{
+public:
+	static const int TEXTURE_UNITS = 4;
+
+	GlStateCache() { invalidate(); }
+	void invalidate();
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+	void bindArrayBuffer(GLuint buffer);
+	void bindFramebuffer(GLuint framebuffer);
+	void bindTexture(GLuint unit, GLuint texture); // a GL_TEXTURE_2D, activates the unit if needed
+	void setBlend(bool enabled);
+	void setDepthTest(bool enabled);
+
+	// GL calls issued and skipped as redundant since the last resetCounters()
+	unsigned int issued = 0;
+	unsigned int elided = 0;
+	void resetCounters() { issued = 0; elided = 0; }
+
+private:
+	// Returns whether the call can be skipped, otherwise records the new value
+	bool redundant(GLuint& shadow, GLuint value);
+
+	GLuint program;
+	GLuint vao;
+	GLuint array_buffer;
+	GLuint framebuffer;
+	GLuint active_unit;
+	GLuint textures[TEXTURE_UNITS];
+	GLuint blend;
+	GLuint depth_test;
+};
+
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
 class RenderSystem {
@@ -17,9 +54,22 @@ class RenderSystem {
 	 * Whenever possible, add to these lists instead of creating dynamic state
 	 * it is easier to debug and faster to execute for the computer.
 	 */
-	std::array<GLuint, texture_count> texture_gl_handles;
 	std::array<ivec2, texture_count> texture_dimensions;
 
+	// Texture atlas
+	// All textures are packed into a few atlas pages at initialization, so that sprites with
+	// different textures can still share a draw call. A texture is a rectangle of its page,
+	// surrounded by a transparent gutter that stands in for the clamp to border of a texture
+	// of its own. Textures larger than a page get a page to themselves.
+	static const int ATLAS_PAGE_SIZE = 2048;
+	static const int ATLAS_GUTTER = 1;
+	std::vector<GLuint> atlas_pages;
+	std::array<GLuint, texture_count> texture_pages; // index into atlas_pages
+	std::array<vec4, texture_count> texture_rects; // offset and scale of the texture in its page
+	GLuint pageHandle(TEXTURE_ASSET_ID id) const { return atlas_pages[texture_pages[(GLuint)id]]; }
+	// Copies the RGBA pixels of texture i to its place in its page
+	void uploadTexture(GLuint i, ivec2 offset, const void* pixels);
+
 	// Make sure these paths remain in sync with the associated enumerators.
 	// Associated id with .obj path
 	const std::vector < std::pair<GEOMETRY_BUFFER_ID, std::string>> mesh_paths =
@@ -104,14 +154,32 @@ class RenderSystem {
 		shader_path("card"),
 		shader_path("animated"),
 		shader_path("textured"),
-		shader_path("wind") };
+		shader_path("wind"),
+		shader_path("sprite"),
+		shader_path("tilemap"),
+		shader_path("debug_lines") };
+
+	// Uniform locations of an effect, looked up once after linking
+	// Names the effect does not use are -1, which GL ignores
+	struct EffectLocations {
+		GLint transform, projection, fcolor;
+		GLint current_frame, num_frames;
+		GLint current_health, max_health_damage, current_damage;
+		GLint time, darken_screen_factor;
+		GLint texrect; // the atlas rectangle of each sampler, see texture_rects
+	};
+	std::array<EffectLocations, effect_count> effect_locations;
 
 	std::array<GLuint, geometry_count> vertex_buffers;
 	std::array<GLuint, geometry_count> index_buffers;
+	std::array<GLsizei, geometry_count> index_counts;
+	// One vertex array object per geometry, each geometry has a single vertex layout
+	std::array<GLuint, geometry_count> vertex_arrays;
 	std::array<Mesh, geometry_count> meshes;
 
 public:
 	// Initialize the window
+	// With no window, for a headless run, only the screen state is created
 	bool init(GLFWwindow* window);
 
 	template <class T>
@@ -125,6 +193,8 @@ public:
 	Mesh& getMesh(GEOMETRY_BUFFER_ID id) { return meshes[(int)id]; };
 
 	void initializeGlGeometryBuffers();
+	// Build the vertex array objects once the buffers are filled
+	void initializeGlVertexArrays();
 	// Initialize the screen texture used as intermediate render target
 	// The draw loop first renders to this texture, then it is used for the wind
 	// shader
@@ -134,17 +204,88 @@ public:
 	~RenderSystem();
 
 	// Draw all entities
-	void draw();
+	// alpha is how far the frame is between the last two simulation ticks, from 0 to 1
+	void draw(float alpha = 1.f);
 
 	mat3 createProjectionMatrix();
 
+	// Number of draw calls issued by the last draw()
+	unsigned int get_draw_calls() const { return draw_calls; }
+	// State changes of the last draw(), see GlStateCache
+	const GlStateCache& get_gl_state() const { return gl_state; }
+
 private:
 	// Internal drawing functions for each entity type
-	void drawTexturedMesh(Entity entity, const mat3& projection);
+	void drawTexturedMesh(Entity entity, const Motion& motion, const RenderRequest& render_request, const mat3& projection);
+	void drawTileMap(Entity entity, const mat3& projection);
+	void drawDebugLines(const mat3& projection);
 	void drawToScreen();
 
-	// Window handle
-	GLFWwindow* window;
+	// Render interpolation
+	// The simulation runs in fixed ticks, see main.cpp, so a frame usually falls between two of
+	// them. Entities are drawn in between their previous and current positions. A motion that
+	// moved further than MAX_INTERPOLATION_DISTANCE in one tick was placed rather than moved,
+	// e.g. a new entity or the player entering a map, and is drawn where it is.
+	static constexpr float MAX_INTERPOLATION_DISTANCE = 100.f;
+	float interpolation = 1.f;
+	vec2 interpolatedPosition(const Motion& motion) const;
+
+	// Instanced sprites
+	// Textured and animated sprites are not drawn one by one. Render requests that are next to
+	// each other in the sorted queue and share an atlas page become one batch, drawn with a single
+	// instanced draw call; everything else is drawn in between, in queue order.
+	struct SpriteInstance {
+		mat3 transform;
+		vec4 texrect; // offset and scale applied to the texture coordinates of the sprite
+		vec3 color;
+	};
+	struct DrawItem {
+		Entity entity;
+		const Motion* motion; // nullptr for a tile map
+		const RenderRequest* render_request; // nullptr for a batch of sprites
+		GLuint texture; // the atlas page
+		GLuint first_instance;
+		GLsizei instance_count;
+	};
+	static bool isInstancedSprite(const RenderRequest& render_request);
+	void addSpriteInstance(Entity entity, const Motion& motion, const RenderRequest& render_request);
+	void drawSpriteBatch(const DrawItem& batch, const mat3& projection);
+
+	// Render queue
+	// Each frame every render request gets a 64-bit key: layer, effect and atlas page in the high
+	// bits and its position in the queue in the low 32 bits. Sorting the keys orders the queue
+	// by layer first and groups equal materials within a layer, the position keeps the order of
+	// otherwise equal requests stable.
+	struct QueuedRequest {
+		Entity entity;
+		const Motion* motion; // nullptr for a tile map
+		const RenderRequest* render_request;
+	};
+	uint64_t sortKey(const RenderRequest& render_request, uint32_t position) const;
+	// Effects that sample used_texture, the others may leave it at TEXTURE_COUNT
+	static bool samplesTexture(EFFECT_ASSET_ID effect);
+	std::vector<QueuedRequest> render_queue;
+	std::vector<uint64_t> render_keys;
+	std::vector<uint64_t> render_keys_scratch;
+
+	std::vector<SpriteInstance> sprite_instances;
+	std::vector<DrawItem> draw_items;
+	GLuint sprite_instance_buffer = 0;
+	GLuint sprite_instance_vao = 0; // the sprite quad plus the instance attributes
+	size_t sprite_instance_capacity = 0; // in instances, the buffer is grown when exceeded
+	unsigned int draw_calls = 0;
+	GlStateCache gl_state;
+
+	// The walls of the tile map being drawn, one texel per tile, see TileMap
+	GLuint tile_texture = 0;
+
+	// The lines of DebugDraw, streamed every frame like the sprite instances
+	GLuint debug_vertex_buffer = 0;
+	GLuint debug_vao = 0;
+	size_t debug_vertex_capacity = 0;
+
+	// Window handle, nullptr until init()
+	GLFWwindow* window = nullptr;
 
 	// Screen texture handles
 	GLuint frame_buffer;
@@ -154,5 +295,16 @@ private:
 	Entity screen_state_entity;
 };
 
+// Attribute locations shared by all effects, bound before linking so that the vertex array
+// object of a geometry works with every effect drawing it
+enum class ATTRIBUTE_LOCATION
+{
+	POSITION = 0,
+	TEXCOORD = POSITION + 1,
+	COLOR = TEXCOORD + 1,
+	TRANSFORM = COLOR + 1, // a mat3 takes three locations
+	TEXRECT = TRANSFORM + 3
+};
+
 bool loadEffectFromFile(
 	const std::string& vs_path, const std::string& fs_path, GLuint& out_program);
\ No newline at end of file
@@ -0,0 +1,36 @@
+// Null render backend of the headless build (IOLS_HEADLESS, the iols_headless target)
+// The headless build compiles this instead of render_system.cpp and render_system_init.cpp, so
+// it links neither GLFW nor GL. The world still creates render requests and meshes, nothing
+// draws them.
+#ifdef IOLS_HEADLESS
+
+// internal
+#include "render_system.hpp"
+#include "tiny_ecs_registry.hpp"
+
+void GlStateCache::invalidate()
+{
+	program = vao = array_buffer = framebuffer = active_unit = blend = depth_test = ~0u;
+	for (GLuint& texture : textures)
+		texture = ~0u;
+}
+
+bool RenderSystem::init(GLFWwindow* window_arg)
+{
+	(void)window_arg;
+	// The screen state lives with the renderer, see initScreenTexture()
+	screen_state_entity = Entity::create();
+	registry.screenStates.emplace(screen_state_entity);
+	return true;
+}
+
+RenderSystem::~RenderSystem()
+{
+}
+
+void RenderSystem::draw(float alpha)
+{
+	(void)alpha;
+}
+
+#endif
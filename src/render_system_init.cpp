@@ -1,8 +1,16 @@
 // internal
 #include "render_system.hpp"
+#include "asset_pack.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <thread>
 
 #include "../ext/stb_image/stb_image.h"
 
@@ -13,11 +21,26 @@
 #include <iostream>
 #include <sstream>
 
+using Clock = std::chrono::steady_clock;
+
+static float milliseconds(Clock::duration duration)
+{
+	return (float)std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000;
+}
+
 // World initialization
 bool RenderSystem::init(GLFWwindow* window_arg)
 {
 	this->window = window_arg;
 
+	// Headless runs only need the screen state, there is nothing to draw to
+	if (window == nullptr)
+	{
+		screen_state_entity = Entity::create();
+		registry.screenStates.emplace(screen_state_entity);
+		return true;
+	}
+
 	glfwMakeContextCurrent(window);
 	glfwSwapInterval(1); // vsync
 
@@ -48,42 +71,127 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 	// code to use OpenGL 4.3 (not suported on mac) and add additional .h and .cpp
 	// glDebugMessageCallback((GLDEBUGPROC)errorCallback, nullptr);
 
-	// We are not really using VAO's but without at least one bound we will crash in
-	// some systems.
+	// The buffers are filled with a throwaway VAO bound, without one we will crash in some
+	// systems. Drawing uses the VAOs built afterwards.
 	GLuint vao;
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	gl_has_errors();
 
+	// Startup time of each step is logged
+	const auto start = Clock::now();
 	initScreenTexture();
-    initializeGlTextures();
+	initializeGlTextures();
+	const auto textures_loaded = Clock::now();
 	initializeGlEffects();
+	const auto effects_loaded = Clock::now();
 	initializeGlGeometryBuffers();
+	initializeGlVertexArrays();
+	const auto geometry_loaded = Clock::now();
+	printf("Renderer startup: textures %.1f ms, effects %.1f ms, geometry %.1f ms, total %.1f ms\n",
+		   milliseconds(textures_loaded - start), milliseconds(effects_loaded - textures_loaded),
+		   milliseconds(geometry_loaded - effects_loaded), milliseconds(geometry_loaded - start));
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &vao);
+	gl_has_errors();
+
+	// The state bound while initializing is not tracked
+	gl_state.invalidate();
 
 	return true;
 }
 
 void RenderSystem::initializeGlTextures()
 {
-    glGenTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	const auto start = Clock::now();
 
-    for(uint i = 0; i < texture_paths.size(); i++)
-    {
+	// Only the image headers are read up front, that is enough to lay out the atlas
+	// Packed images are already decoded, see asset_pack.hpp
+	std::array<const AssetPackEntry*, texture_count> packed;
+	for(uint i = 0; i < texture_paths.size(); i++)
+	{
 		const std::string& path = texture_paths[i];
 		ivec2& dimensions = texture_dimensions[i];
-
-		stbi_uc* data;
-		data = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
-
-		if (data == NULL)
+		packed[i] = asset_pack.find(path);
+		if (packed[i] && packed[i]->kind == ASSET_KIND::TEXTURE)
+			dimensions = { (int)packed[i]->width, (int)packed[i]->height };
+		else if (!stbi_info(path.c_str(), &dimensions.x, &dimensions.y, NULL))
 		{
 			const std::string message = "Could not load the file " + path + ".";
 			fprintf(stderr, "%s", message.c_str());
 			assert(false);
 		}
+	}
 
-		glBindTexture(GL_TEXTURE_2D, texture_gl_handles[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	// Shelf packing, the textures are placed left to right in rows as high as their highest
+	// texture, tallest first so that the rows waste little space
+	GLint max_texture_size;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	const int page_size = std::min((int)ATLAS_PAGE_SIZE, (int)max_texture_size);
+
+	std::array<uint, texture_count> order;
+	for (uint i = 0; i < texture_count; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](uint a, uint b) {
+		return texture_dimensions[a].y > texture_dimensions[b].y;
+	});
+
+	std::vector<ivec2> page_sizes;
+	std::array<ivec2, texture_count> offsets;
+	int page = -1;
+	ivec2 cursor = { 0, 0 };
+	int shelf_height = 0;
+	for (uint i : order)
+	{
+		const ivec2 padded = texture_dimensions[i] + 2 * ATLAS_GUTTER;
+		if (padded.x > page_size || padded.y > page_size)
+		{
+			texture_pages[i] = (GLuint)page_sizes.size();
+			offsets[i] = { ATLAS_GUTTER, ATLAS_GUTTER };
+			page_sizes.push_back(padded);
+			continue;
+		}
+
+		// Next row, or next page
+		if (page >= 0 && cursor.x + padded.x > page_size)
+		{
+			cursor = { 0, cursor.y + shelf_height };
+			shelf_height = 0;
+		}
+		if (page < 0 || cursor.y + padded.y > page_size)
+		{
+			page = (int)page_sizes.size();
+			page_sizes.push_back({ page_size, page_size });
+			cursor = { 0, 0 };
+			shelf_height = 0;
+		}
+
+		texture_pages[i] = (GLuint)page;
+		offsets[i] = cursor + ATLAS_GUTTER;
+		cursor.x += padded.x;
+		shelf_height = std::max(shelf_height, padded.y);
+	}
+
+	for (uint i = 0; i < texture_count; i++)
+	{
+		const ivec2 size = page_sizes[texture_pages[i]];
+		texture_rects[i] = {
+			(float)offsets[i].x / size.x, (float)offsets[i].y / size.y,
+			(float)texture_dimensions[i].x / size.x, (float)texture_dimensions[i].y / size.y };
+	}
+
+	// Create the pages, everything not covered by a texture stays transparent
+	atlas_pages.resize(page_sizes.size());
+	glGenTextures((GLsizei)atlas_pages.size(), atlas_pages.data());
+	std::vector<stbi_uc> transparent;
+	for (uint p = 0; p < atlas_pages.size(); p++)
+	{
+		const ivec2 size = page_sizes[p];
+		transparent.resize(std::max(transparent.size(), (size_t)size.x * size.y * 4), 0);
+
+		glBindTexture(GL_TEXTURE_2D, atlas_pages[p]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent.data());
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
@@ -94,21 +202,266 @@ void RenderSystem::initializeGlTextures()
 		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, color);
 
 		gl_has_errors();
-		stbi_image_free(data);
-    }
+	}
+	const auto laid_out = Clock::now();
+
+	// Packed images are uploaded straight from the mapped pack
+	uint loose_count = 0;
+	for (uint i = 0; i < texture_count; i++)
+	{
+		if (!packed[i] || packed[i]->kind != ASSET_KIND::TEXTURE)
+		{
+			packed[i] = nullptr;
+			loose_count++;
+			continue;
+		}
+		uploadTexture(i, offsets[i], asset_pack.contents(*packed[i]));
+	}
+
+	// Decode the loose images as jobs, while this thread, which owns the GL context, uploads
+	// every image as soon as it is decoded and decodes images itself when none is ready
+	// stbi_load does not share state between calls, except for the reason of the last failure
+	std::vector<std::pair<uint, JobFuture<stbi_uc*>>> decodes;
+	for (uint i = 0; i < texture_count; i++)
+	{
+		if (packed[i])
+			continue;
+		decodes.emplace_back(i, job_system.async([this, i]() {
+			PROFILE_SCOPE("decode texture");
+			ivec2 dimensions;
+			stbi_uc* image = stbi_load(texture_paths[i].c_str(), &dimensions.x, &dimensions.y, NULL, 4);
+			assert(!image || dimensions == texture_dimensions[i]);
+			return image;
+		}));
+	}
+
+	Clock::duration waiting(0);
+	while (!decodes.empty())
+	{
+		auto decoded = std::find_if(decodes.begin(), decodes.end(),
+			[](const std::pair<uint, JobFuture<stbi_uc*>>& decode) { return decode.second.is_ready(); });
+		if (decoded == decodes.end())
+		{
+			const auto wait_start = Clock::now();
+			if (!job_system.run_one())
+				std::this_thread::yield();
+			waiting += Clock::now() - wait_start;
+			continue;
+		}
+
+		const uint i = decoded->first;
+		stbi_uc* image = decoded->second.get();
+		decodes.erase(decoded);
+		if (image == NULL)
+		{
+			const std::string message = "Could not load the file " + texture_paths[i] + ".";
+			fprintf(stderr, "%s", message.c_str());
+			assert(false);
+			continue;
+		}
+
+		uploadTexture(i, offsets[i], image);
+		stbi_image_free(image);
+	}
+	gl_has_errors();
+
+	printf("Textures: %d images on %d atlas pages (%d packed), layout %.1f ms, decode and upload %.1f ms on %d threads (%.1f ms decoding or waiting on this thread)\n",
+		   texture_count, (int)atlas_pages.size(), texture_count - (int)loose_count, milliseconds(laid_out - start),
+		   milliseconds(Clock::now() - laid_out), job_system.get_thread_count(), milliseconds(waiting));
+}
+
+void RenderSystem::uploadTexture(GLuint i, ivec2 offset, const void* pixels)
+{
+	glBindTexture(GL_TEXTURE_2D, atlas_pages[texture_pages[i]]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, texture_dimensions[i].x, texture_dimensions[i].y,
+					GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 	gl_has_errors();
 }
 
+// Source of a shader, from the asset pack if it is packed, otherwise read into storage
+static bool readShaderSource(const std::string& path, std::string& storage, const char*& source, GLsizei& length)
+{
+	const AssetPackEntry* packed = asset_pack.find(path);
+	if (packed && packed->kind == ASSET_KIND::SHADER)
+	{
+		source = (const char*)asset_pack.contents(*packed);
+		length = (GLsizei)packed->size;
+		return true;
+	}
+
+	std::ifstream is(path);
+	if (!is.good())
+		return false;
+	std::stringstream ss;
+	ss << is.rdbuf();
+	storage = ss.str();
+	source = storage.c_str();
+	length = (GLsizei)storage.size();
+	return true;
+}
+
+// Program binary cache
+// Linked programs are saved to data/shader_cache, one file per effect, and later starts load
+// them instead of compiling. A cache file is only valid for the driver and the shader sources
+// it was built from, so they are hashed into a key stored with it; on any mismatch the effect
+// is compiled from source and the file replaced.
+// Bump when something else that goes into a program changes, e.g. the attribute locations
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader
+{
+	char magic[4]; // "IOLS"
+	uint32_t version;
+	uint64_t key;
+	GLenum format;
+	uint32_t length;
+};
+
+// FNV-1a
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+static bool programCacheAvailable()
+{
+	if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+		return false;
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	return format_count > 0;
+}
+
+// Key of the cache file of an effect, 0 if a source is missing
+static uint64_t programCacheKey(const std::string& vs_path, const std::string& fs_path)
+{
+	uint64_t key = hash_bytes(14695981039346656037ull, &PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const char* driver = (const char*)glGetString(name);
+		if (driver)
+			key = hash_bytes(key, driver, strlen(driver) + 1);
+	}
+	for (const std::string* path : { &vs_path, &fs_path })
+	{
+		std::string storage;
+		const char* source;
+		GLsizei length;
+		if (!readShaderSource(*path, storage, source, length))
+			return 0;
+		key = hash_bytes(key, source, length);
+	}
+	return key;
+}
+
+static bool loadProgramBinary(const std::string& path, uint64_t key, GLuint& out_program)
+{
+	std::ifstream is(path, std::ios::binary);
+	ProgramCacheHeader header;
+	if (!is.read((char*)&header, sizeof(header)) || memcmp(header.magic, "IOLS", 4) != 0 ||
+		header.version != PROGRAM_CACHE_VERSION || header.key != key)
+		return false;
+	std::vector<char> binary(header.length);
+	if (!is.read(binary.data(), binary.size()))
+		return false;
+
+	// The driver may still reject the binary, then the effect is compiled from source
+	out_program = glCreateProgram();
+	glProgramBinary(out_program, header.format, binary.data(), (GLsizei)binary.size());
+	GLint is_linked = GL_FALSE;
+	glGetProgramiv(out_program, GL_LINK_STATUS, &is_linked);
+	if (glGetError() != GL_NO_ERROR || is_linked == GL_FALSE)
+	{
+		glDeleteProgram(out_program);
+		out_program = 0;
+		return false;
+	}
+	return true;
+}
+
+static void saveProgramBinary(const std::string& path, uint64_t key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	ProgramCacheHeader header = {};
+	memcpy(header.magic, "IOLS", 4);
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	glGetProgramBinary(program, length, &length, &header.format, binary.data());
+	header.length = (uint32_t)length;
+	if (gl_has_errors())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+	std::ofstream os(path, std::ios::binary | std::ios::trunc);
+	os.write((const char*)&header, sizeof(header));
+	os.write(binary.data(), length);
+	if (!os.good())
+		fprintf(stderr, "Failed to write the program binary cache %s\n", path.c_str());
+}
+
 void RenderSystem::initializeGlEffects()
 {
+	const bool use_cache = programCacheAvailable();
+	Clock::duration compile_time(0), cache_time(0);
+	int cached_count = 0;
+
 	for(uint i = 0; i < effect_paths.size(); i++)
 	{
 		const std::string vertex_shader_name = effect_paths[i] + ".vs.glsl";
 		const std::string fragment_shader_name = effect_paths[i] + ".fs.glsl";
+		const std::string cache_file = shader_cache_path(std::filesystem::path(effect_paths[i]).filename().string() + ".bin");
+
+		const auto start = Clock::now();
+		const uint64_t key = use_cache ? programCacheKey(vertex_shader_name, fragment_shader_name) : 0;
+		if (key != 0 && loadProgramBinary(cache_file, key, effects[i]))
+		{
+			cached_count++;
+			cache_time += Clock::now() - start;
+		}
+		else
+		{
+			bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
+			assert(is_valid && (GLuint)effects[i] != 0);
+			if (is_valid && key != 0)
+				saveProgramBinary(cache_file, key, effects[i]);
+			compile_time += Clock::now() - start;
+		}
 
-		bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
-		assert(is_valid && (GLuint)effects[i] != 0);
+		// Look up all locations now, the draw loop does not query GL
+		const GLuint program = effects[i];
+		EffectLocations& locations = effect_locations[i];
+		locations.transform = glGetUniformLocation(program, "transform");
+		locations.projection = glGetUniformLocation(program, "projection");
+		locations.fcolor = glGetUniformLocation(program, "fcolor");
+		locations.current_frame = glGetUniformLocation(program, "current_frame");
+		locations.num_frames = glGetUniformLocation(program, "num_frames");
+		locations.current_health = glGetUniformLocation(program, "current_health");
+		locations.max_health_damage = glGetUniformLocation(program, "max_health_damage");
+		locations.current_damage = glGetUniformLocation(program, "current_damage");
+		locations.time = glGetUniformLocation(program, "time");
+		locations.darken_screen_factor = glGetUniformLocation(program, "darken_screen_factor");
+		locations.texrect = glGetUniformLocation(program, "texrect");
+
+		// Samplers always use the same texture slots, sampler0 is slot 0 and so on
+		glUseProgram(program);
+		const char* samplers[] = { "sampler0", "sampler1", "sampler2", "sampler3" };
+		for (int slot = 0; slot < 4; slot++)
+			glUniform1i(glGetUniformLocation(program, samplers[slot]), slot);
+		gl_has_errors();
 	}
+	glUseProgram(0);
+
+	printf("Effects: %d compiled from source in %.1f ms, %d loaded from the program binary cache in %.1f ms%s\n",
+		   (int)effect_count - cached_count, milliseconds(compile_time), cached_count, milliseconds(cache_time),
+		   use_cache ? "" : " (not supported by the driver)");
 }
 
 // One could merge the following two functions as a template function...
@@ -123,6 +476,7 @@ void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(uint)gid]);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
 		sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	index_counts[(uint)gid] = (GLsizei)indices.size();
 	gl_has_errors();
 }
 
@@ -151,6 +505,10 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Index Buffer creation.
 	glGenBuffers((GLsizei)index_buffers.size(), index_buffers.data());
 
+	// Instance buffer of the sprites and vertex buffer of the debug lines, filled every frame
+	glGenBuffers(1, &sprite_instance_buffer);
+	glGenBuffers(1, &debug_vertex_buffer);
+
 	// Index and Vertex buffer data initialization.
 	initializeGlMeshes();
 
@@ -233,13 +591,88 @@ void RenderSystem::initializeGlGeometryBuffers()
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE, screen_vertices, screen_indices);
 }
 
+void RenderSystem::initializeGlVertexArrays()
+{
+	glGenVertexArrays((GLsizei)vertex_arrays.size(), vertex_arrays.data());
+	const GLuint position = (GLuint)ATTRIBUTE_LOCATION::POSITION;
+
+	for (uint i = 0; i < geometry_count; i++)
+	{
+		glBindVertexArray(vertex_arrays[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[i]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[i]);
+
+		glEnableVertexAttribArray(position);
+		switch ((GEOMETRY_BUFFER_ID)i)
+		{
+		case GEOMETRY_BUFFER_ID::SPRITE:
+			glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void *)0);
+			glEnableVertexAttribArray((GLuint)ATTRIBUTE_LOCATION::TEXCOORD);
+			glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::TEXCOORD, 2, GL_FLOAT, GL_FALSE,
+				sizeof(TexturedVertex), (void *)sizeof(vec3)); // note the stride to skip the preceeding vertex position
+			break;
+		case GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE:
+			glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void *)0);
+			break;
+		default:
+			// Meshes, the egg and the debug line are coloured
+			glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void *)0);
+			glEnableVertexAttribArray((GLuint)ATTRIBUTE_LOCATION::COLOR);
+			glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::COLOR, 3, GL_FLOAT, GL_FALSE,
+				sizeof(ColoredVertex), (void *)sizeof(vec3));
+			break;
+		}
+		gl_has_errors();
+	}
+
+	// The instanced sprites use the sprite quad plus per instance attributes. These point into
+	// the instance buffer at the first instance of each batch, so they are set when drawing.
+	glGenVertexArrays(1, &sprite_instance_vao);
+	glBindVertexArray(sprite_instance_vao);
+	const GLuint sprite = (GLuint)GEOMETRY_BUFFER_ID::SPRITE;
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[sprite]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[sprite]);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void *)0);
+	glEnableVertexAttribArray((GLuint)ATTRIBUTE_LOCATION::TEXCOORD);
+	glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::TEXCOORD, 2, GL_FLOAT, GL_FALSE,
+		sizeof(TexturedVertex), (void *)sizeof(vec3));
+	for (GLuint location = (GLuint)ATTRIBUTE_LOCATION::COLOR; location <= (GLuint)ATTRIBUTE_LOCATION::TEXRECT; location++)
+	{
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+	gl_has_errors();
+
+	// The debug lines are coloured vertices in window coordinates
+	glGenVertexArrays(1, &debug_vao);
+	glBindVertexArray(debug_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, debug_vertex_buffer);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void *)0);
+	glEnableVertexAttribArray((GLuint)ATTRIBUTE_LOCATION::COLOR);
+	glVertexAttribPointer((GLuint)ATTRIBUTE_LOCATION::COLOR, 3, GL_FLOAT, GL_FALSE,
+		sizeof(ColoredVertex), (void *)sizeof(vec3));
+	gl_has_errors();
+}
+
 RenderSystem::~RenderSystem()
 {
+	// Nothing was created without init(), e.g. in a headless run
+	if (window == nullptr)
+		return;
+
 	// Don't need to free gl resources since they last for as long as the program,
 	// but it's polite to clean after yourself.
 	glDeleteBuffers((GLsizei)vertex_buffers.size(), vertex_buffers.data());
 	glDeleteBuffers((GLsizei)index_buffers.size(), index_buffers.data());
-	glDeleteTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	glDeleteBuffers(1, &sprite_instance_buffer);
+	glDeleteBuffers(1, &debug_vertex_buffer);
+	glDeleteVertexArrays((GLsizei)vertex_arrays.size(), vertex_arrays.data());
+	glDeleteVertexArrays(1, &sprite_instance_vao);
+	glDeleteVertexArrays(1, &debug_vao);
+	glDeleteTextures((GLsizei)atlas_pages.size(), atlas_pages.data());
+	glDeleteTextures(1, &tile_texture);
 	glDeleteTextures(1, &off_screen_render_buffer_color);
 	glDeleteRenderbuffers(1, &off_screen_render_buffer_depth);
 	gl_has_errors();
@@ -259,6 +692,7 @@ RenderSystem::~RenderSystem()
 // Initialize the screen texture from a standard sprite
 bool RenderSystem::initScreenTexture()
 {
+	screen_state_entity = Entity::create();
 	registry.screenStates.emplace(screen_state_entity);
 
 	int framebuffer_width, framebuffer_height;
@@ -309,27 +743,18 @@ bool gl_compile_shader(GLuint shader)
 bool loadEffectFromFile(
 	const std::string& vs_path, const std::string& fs_path, GLuint& out_program)
 {
-	// Opening files
-	std::ifstream vs_is(vs_path);
-	std::ifstream fs_is(fs_path);
-	if (!vs_is.good() || !fs_is.good())
+	// Reading sources
+	std::string vs_str, fs_str;
+	const char* vs_src;
+	const char* fs_src;
+	GLsizei vs_len, fs_len;
+	if (!readShaderSource(vs_path, vs_str, vs_src, vs_len) || !readShaderSource(fs_path, fs_str, fs_src, fs_len))
 	{
 		fprintf(stderr, "Failed to load shader files %s, %s", vs_path.c_str(), fs_path.c_str());
 		assert(false);
 		return false;
 	}
 
-	// Reading sources
-	std::stringstream vs_ss, fs_ss;
-	vs_ss << vs_is.rdbuf();
-	fs_ss << fs_is.rdbuf();
-	std::string vs_str = vs_ss.str();
-	std::string fs_str = fs_ss.str();
-	const char* vs_src = vs_str.c_str();
-	const char* fs_src = fs_str.c_str();
-	GLsizei vs_len = (GLsizei)vs_str.size();
-	GLsizei fs_len = (GLsizei)fs_str.size();
-
 	GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex, 1, &vs_src, &vs_len);
 	GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
@@ -354,6 +779,14 @@ bool loadEffectFromFile(
 	out_program = glCreateProgram();
 	glAttachShader(out_program, vertex);
 	glAttachShader(out_program, fragment);
+	glBindAttribLocation(out_program, (GLuint)ATTRIBUTE_LOCATION::POSITION, "in_position");
+	glBindAttribLocation(out_program, (GLuint)ATTRIBUTE_LOCATION::TEXCOORD, "in_texcoord");
+	glBindAttribLocation(out_program, (GLuint)ATTRIBUTE_LOCATION::COLOR, "in_color");
+	glBindAttribLocation(out_program, (GLuint)ATTRIBUTE_LOCATION::TRANSFORM, "in_transform");
+	glBindAttribLocation(out_program, (GLuint)ATTRIBUTE_LOCATION::TEXRECT, "in_texrect");
+	// Allows saving the program to the program binary cache
+	if (glProgramParameteri)
+		glProgramParameteri(out_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(out_program);
 	gl_has_errors();
 
@@ -0,0 +1,96 @@
+// internal
+#include "task_scheduler.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
+
+// stlib
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+void TaskScheduler::add(const char* name, const TaskAccess& access, std::function<void()> work)
+{
+	std::unique_ptr<Task> added = std::make_unique<Task>();
+	added->name = name;
+	added->access = access;
+	added->work = std::move(work);
+
+	// Conflicting tasks keep the order they were added in
+	for (const std::unique_ptr<Task>& earlier : tasks)
+	{
+		if (earlier->access.conflicts_with(access))
+		{
+			earlier->successors.push_back(tasks.size());
+			added->predecessor_count++;
+		}
+	}
+	tasks.push_back(std::move(added));
+}
+
+void TaskScheduler::schedule(size_t task)
+{
+	if (tasks[task]->access.is_structural)
+	{
+		std::lock_guard<std::mutex> lock(structural_mutex);
+		structural_tasks.push_back(task);
+	}
+	else
+		job_system.submit([this, task]() { execute(task); });
+}
+
+void TaskScheduler::execute(size_t task)
+{
+	Task& executed = *tasks[task];
+	const auto start = Clock::now();
+	executed.work();
+	task_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+		std::memory_order_relaxed);
+
+	// The successors are made ready before this task counts as done, so the run cannot end early
+	for (size_t successor : executed.successors)
+	{
+		if (tasks[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			schedule(successor);
+	}
+	remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void TaskScheduler::run()
+{
+	PROFILE_SCOPE("TaskScheduler::run");
+	if (tasks.empty())
+		return;
+
+	const auto start = Clock::now();
+	task_ns.store(0, std::memory_order_relaxed);
+	for (const std::unique_ptr<Task>& task : tasks)
+		task->pending.store(task->predecessor_count, std::memory_order_relaxed);
+	remaining.store(tasks.size(), std::memory_order_release);
+
+	for (size_t task = 0; task < tasks.size(); task++)
+	{
+		if (tasks[task]->predecessor_count == 0)
+			schedule(task);
+	}
+
+	// This thread runs the structural tasks and helps with the others
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		size_t structural = tasks.size();
+		{
+			std::lock_guard<std::mutex> lock(structural_mutex);
+			if (!structural_tasks.empty())
+			{
+				structural = structural_tasks.front();
+				structural_tasks.pop_front();
+			}
+		}
+		if (structural < tasks.size())
+			execute(structural);
+		else if (!job_system.run_one())
+			std::this_thread::yield();
+	}
+
+	const int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	parallelism = wall_ns > 0 ? (float)task_ns.load(std::memory_order_relaxed) / wall_ns : 1.f;
+}
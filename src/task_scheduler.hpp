@@ -0,0 +1,77 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tiny_ecs.hpp"
+
+// The registry containers a task reads and writes, as signature masks, see Registry::mask()
+// Tasks that only change the values of components do not change the registry's structure and
+// can run alongside each other. A structural task adds or removes entities or components, or
+// calls into GLFW, GL or audio; it conflicts with every other task and runs on the thread that
+// calls TaskScheduler::run().
+struct TaskAccess
+{
+	Signature reads = 0;
+	Signature writes = 0;
+	bool is_structural = false;
+
+	bool conflicts_with(const TaskAccess& other) const
+	{
+		return is_structural || other.is_structural ||
+			(writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+	}
+};
+
+constexpr TaskAccess STRUCTURAL_ACCESS = { 0, 0, true };
+
+// Task graph scheduler
+// Tasks are added once, in the order the game would run them one after the other. A task
+// depends on every earlier task it conflicts with, so each run gives the same results as
+// running the tasks in order, while tasks that do not conflict run at the same time as jobs
+// of the JobSystem.
+class TaskScheduler
+{
+public:
+	TaskScheduler() = default;
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	// name must outlive the scheduler, e.g. a string literal
+	void add(const char* name, const TaskAccess& access, std::function<void()> work);
+
+	// Runs every task once and returns when all of them are done
+	void run();
+
+	// Achieved parallelism of the last run: the time spent in tasks over the time run() took
+	// The time run() spends scheduling and waiting for jobs counts as well, so the value is
+	// below 1 when the tasks ran one after the other and only goes above 1 when they overlapped
+	float get_parallelism() const { return parallelism; }
+
+private:
+	struct Task {
+		const char* name;
+		TaskAccess access;
+		std::function<void()> work;
+		std::vector<size_t> successors;
+		unsigned int predecessor_count = 0;
+		std::atomic<unsigned int> pending{ 0 }; // predecessors not done yet in this run
+	};
+	std::vector<std::unique_ptr<Task>> tasks;
+
+	// Ready structural tasks, only taken by the thread calling run()
+	std::mutex structural_mutex;
+	std::deque<size_t> structural_tasks;
+
+	void schedule(size_t task); // once it is ready
+	void execute(size_t task);
+
+	std::atomic<size_t> remaining{ 0 }; // tasks not done yet in this run
+	std::atomic<int64_t> task_ns{ 0 };
+	float parallelism = 1.f;
+};
@@ -1,5 +1,54 @@
 // internal
 #include "tiny_ecs.hpp"
 
+// stlib
+#include <cstdlib>
+
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+unsigned int Entity::index_count = 1;
+std::deque<unsigned int> Entity::free_indices;
+const unsigned int SparseIndex::INVALID_SLOT;
+std::unique_ptr<unsigned short[]> Entity::generation_pages[Entity::MAX_INDEX >> Entity::GENERATION_PAGE_BITS];
+
+unsigned int Entity::generation_of(unsigned int index)
+{
+	const std::unique_ptr<unsigned short[]>& page = generation_pages[index >> GENERATION_PAGE_BITS];
+	return page ? page[index & ((1u << GENERATION_PAGE_BITS) - 1)] : 0;
+}
+
+unsigned int Entity::allocate()
+{
+	unsigned int index;
+	// Once all fresh slots are used the released ones are handed out regardless of how many wait
+	if (free_indices.size() > MINIMUM_FREE_INDICES || (index_count == MAX_INDEX && !free_indices.empty()))
+	{
+		index = free_indices.front();
+		free_indices.pop_front();
+	}
+	else
+	{
+		if (index_count == MAX_INDEX)
+		{
+			fprintf(stderr, "Too many live entities, at most %u can exist at once\n", MAX_INDEX - 1);
+			abort();
+		}
+		index = index_count++;
+
+		// Fresh slots start at generation 0
+		std::unique_ptr<unsigned short[]>& page = generation_pages[index >> GENERATION_PAGE_BITS];
+		if (!page)
+			page.reset(new unsigned short[1u << GENERATION_PAGE_BITS]());
+	}
+	return (generation_of(index) << INDEX_BITS) | index;
+}
+
+void Entity::destroy(Entity e)
+{
+	if (!e.is_alive())
+		return;
+
+	const unsigned int index = e.index();
+	unsigned short& generation = generation_pages[index >> GENERATION_PAGE_BITS][index & ((1u << GENERATION_PAGE_BITS) - 1)];
+	generation = (unsigned short)((generation + 1) & ((1u << GENERATION_BITS) - 1));
+	free_indices.push_back(index);
+}
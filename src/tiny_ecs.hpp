@@ -2,50 +2,210 @@
 
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <deque>
 #include <set>
 #include <functional>
+#include <iterator>
 #include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <cstdio>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
 #include <assert.h>
 
 // Unique identifyer for all entities
+// The handle packs the index of an entity slot in the low bits and the generation of that slot
+// in the high bits. Slots are re-used once their entity is destroyed, and the generation is
+// bumped on every release so that old handles to the slot no longer compare equal.
+// A default constructed handle is null, it refers to no entity; Entity::create() makes one.
 class Entity
 {
-	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
+	unsigned int id = 0;
+	explicit Entity(unsigned int id_arg) : id(id_arg) {}
 public:
-	Entity()
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int GENERATION_BITS = 32 - INDEX_BITS;
+	static const unsigned int MAX_INDEX = 1u << INDEX_BITS;
+	// Released slots are only handed out again once this many are waiting, which spreads the
+	// generation increments so a wrapped generation is very unlikely to alias a stale handle
+	static const unsigned int MINIMUM_FREE_INDICES = 1024;
+
+	Entity() = default;
+
+	// A new entity in a free slot
+	static Entity create() { return Entity(allocate()); }
+	bool is_null() const { return id == 0; }
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+
+	unsigned int index() const { return id & (MAX_INDEX - 1); }
+	unsigned int generation() const { return id >> INDEX_BITS; }
+
+	// A handle is alive until its entity is destroyed, comparing the generation is enough
+	bool is_alive() const { return index() != 0 && generation() == generation_of(index()); }
+
+	// Release the slot of the entity for re-use, invalidating all handles to it
+	static void destroy(Entity e);
+
+private:
+	static unsigned int allocate();
+	static unsigned int generation_of(unsigned int index);
+
+	// Generations are stored in pages that never move once allocated
+	static const unsigned int GENERATION_PAGE_BITS = 12;
+	static std::unique_ptr<unsigned short[]> generation_pages[MAX_INDEX >> GENERATION_PAGE_BITS];
+	static unsigned int index_count; // starts from 1, entity 0 is the default initialization
+	static std::deque<unsigned int> free_indices;
+};
+
+// Maps entity ids to slots of a dense array. The ids are split into fixed-size pages that
+// are only allocated once an id in their range is used, so a lookup is two array reads
+// instead of a hash and there is no allocation per inserted entity.
+class SparseIndex
+{
+public:
+	static const unsigned int PAGE_BITS = 10;
+	static const unsigned int PAGE_SIZE = 1u << PAGE_BITS;
+	static const unsigned int INVALID_SLOT = ~0u;
+
+	// Returns the dense slot stored for the id, or INVALID_SLOT if there is none
+	unsigned int find(unsigned int id) const
+	{
+		const unsigned int page = id >> PAGE_BITS;
+		if (page >= pages.size() || !pages[page])
+			return INVALID_SLOT;
+		return pages[page][id & (PAGE_SIZE - 1)];
+	}
+
+	void set(unsigned int id, unsigned int slot)
+	{
+		const unsigned int page = id >> PAGE_BITS;
+		if (page >= pages.size())
+			pages.resize(page + 1);
+		if (!pages[page])
+		{
+			pages[page].reset(new unsigned int[PAGE_SIZE]);
+			std::fill(pages[page].get(), pages[page].get() + PAGE_SIZE, INVALID_SLOT);
+		}
+		pages[page][id & (PAGE_SIZE - 1)] = slot;
+	}
+
+	void reset(unsigned int id)
+	{
+		const unsigned int page = id >> PAGE_BITS;
+		if (page < pages.size() && pages[page])
+			pages[page][id & (PAGE_SIZE - 1)] = INVALID_SLOT;
+	}
+
+private:
+	std::vector<std::unique_ptr<unsigned int[]>> pages;
+};
+
+// One bit per container of a registry, set for every container an entity has a component in
+typedef uint64_t Signature;
+
+// The component signatures of all entities, by entity index. Like the generations of Entity they
+// are stored in pages that never move, so containers can keep a pointer to the store.
+class SignatureStore
+{
+public:
+	static const unsigned int PAGE_BITS = 10;
+	static const unsigned int PAGE_SIZE = 1u << PAGE_BITS;
+
+	Signature get(unsigned int index) const
+	{
+		const unsigned int page = index >> PAGE_BITS;
+		if (page >= pages.size() || !pages[page])
+			return 0;
+		return pages[page][index & (PAGE_SIZE - 1)];
+	}
+
+	void add(unsigned int index, Signature bits)
+	{
+		const unsigned int page = index >> PAGE_BITS;
+		if (page >= pages.size())
+			pages.resize(page + 1);
+		if (!pages[page])
+			pages[page].reset(new Signature[PAGE_SIZE]());
+		pages[page][index & (PAGE_SIZE - 1)] |= bits;
+	}
+
+	void remove(unsigned int index, Signature bits)
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		const unsigned int page = index >> PAGE_BITS;
+		if (page < pages.size() && pages[page])
+			pages[page][index & (PAGE_SIZE - 1)] &= ~bits;
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
+
+private:
+	std::vector<std::unique_ptr<Signature[]>> pages;
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+// The entities held by a container and the sparse index into their dense slots. This part does
+// not depend on the component type, so views can test membership of any container through it.
+class EntitySet
 {
-	virtual void clear() = 0;
-	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+protected:
+	// The sparse set index from Entity -> array index.
+	SparseIndex sparse_index;
+	// Signature bit of this container in the registry that owns it, if any
+	SignatureStore* signatures = nullptr;
+	Signature signature_bit = 0;
+
+	void add_signature(Entity e)
+	{
+		if (signatures)
+			signatures->add(e.index(), signature_bit);
+	}
+	void remove_signature(Entity e)
+	{
+		if (signatures)
+			signatures->remove(e.index(), signature_bit);
+	}
+public:
+	// The entities, in the same order as the components of the container
+	std::vector<Entity> entities;
+
+	// Dense slot of the entity, or SparseIndex::INVALID_SLOT if it is not contained
+	// The stored handle is compared as well, so stale handles to a re-used slot are rejected
+	unsigned int slot_of(Entity entity) const
+	{
+		const unsigned int slot = sparse_index.find(entity.index());
+		return (slot != SparseIndex::INVALID_SLOT && entities[slot] == entity) ? slot : SparseIndex::INVALID_SLOT;
+	}
+
+	bool has(Entity entity) const
+	{
+		return slot_of(entity) != SparseIndex::INVALID_SLOT;
+	}
+
+	size_t size() const
+	{
+		return entities.size();
+	}
+
+	// Keep the signature bit of the container up to date in the given store
+	void track(SignatureStore& store, Signature bit)
+	{
+		signatures = &store;
+		signature_bit = bit;
+	}
 };
 
 // A container that stores components of type 'Component' and associated entities
-template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+// Empty component types are only markers and get a container without payload, see below
+template <typename Component, bool IsTag = std::is_empty<Component>::value> // A component can be any class
+class ComponentContainer : public EntitySet
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
 	bool registered = false;
 public:
 	// Container of all components of type 'Component'
 	std::vector<Component> components;
 
-	// The corresponding entities
-	std::vector<Entity> entities;
-
 	// Constructor that registers the type
 	ComponentContainer()
 	{
@@ -57,9 +217,10 @@ public:
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		sparse_index.set(e.index(), (unsigned int)components.size());
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
+		add_signature(e);
 		return components.back();
 	};
 
@@ -76,50 +237,49 @@ public:
 	// A wrapper to return the component of an entity
 	Component& get(Entity e) {
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return components[sparse_index.find(e.index())];
 	}
 
-	// Check if entity has a component of type 'Component'
-	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+	// Returns the component of an entity, or nullptr if it has none; saves a second lookup after has()
+	Component* find(Entity e) {
+		const unsigned int slot = slot_of(e);
+		return slot != SparseIndex::INVALID_SLOT ? &components[slot] : nullptr;
 	}
 
+
 	// Remove an component and pack the container to re-use the empty space
 	void remove(Entity e)
 	{
-		if (has(e))
+		const unsigned int cID = slot_of(e);
+		if (cID != SparseIndex::INVALID_SLOT)
 		{
-			// Get the current position
-			int cID = map_entity_componentID[e];
-
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			sparse_index.set(entities.back().index(), cID);
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			sparse_index.reset(e.index());
+			remove_signature(e);
 			components.pop_back();
 			entities.pop_back();
-			// Note, one could mark the id for re-use
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// Only the slots in use are reset, the pages stay allocated for the next frame
+		for (Entity e : entities)
+		{
+			sparse_index.reset(e.index());
+			remove_signature(e);
+		}
 		components.clear();
 		entities.clear();
 	}
 
-	// Report the number of components of type 'Component'
-	size_t size()
-	{
-		return components.size();
-	}
-
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
 	template <class Compare>
 	void sort(Compare comparisonFunction)
@@ -128,10 +288,333 @@ public:
 		std::sort(entities.begin(), entities.end(), comparisonFunction);
 		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
 		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
+		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(components[sparse_index.find(e.index())]); }); // note, this still uses the old sparse index (on purpose!)
 		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
+		// Fill the new sparse index
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+			sparse_index.set(entities[i].index(), i);
+	}
+};
+
+// A container for empty marker components, e.g. Traversable. Only the membership is stored: the
+// entities for iteration, their sparse index for removal, and one bit per entity index so that
+// has() is a bit test plus the generation check of the handle. All entities share one instance
+// of the empty component.
+template <typename Component>
+class ComponentContainer<Component, true> : public EntitySet
+{
+	static Component instance;
+	std::vector<uint64_t> bits;
+
+	bool test(unsigned int index) const
+	{
+		return (index >> 6) < bits.size() && (bits[index >> 6] >> (index & 63)) & 1;
+	}
+
+public:
+	// Inserting the marker for entity e, an entity is contained at most once
+	Component& insert(Entity e, Component = {}, bool check_for_duplicates = true)
+	{
+		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+		if (has(e))
+			return instance;
+
+		const unsigned int index = e.index();
+		if ((index >> 6) >= bits.size())
+			bits.resize((index >> 6) + 1, 0);
+		bits[index >> 6] |= uint64_t(1) << (index & 63);
+		sparse_index.set(index, (unsigned int)entities.size());
+		entities.push_back(e);
+		add_signature(e);
+		return instance;
+	}
+
+	template<typename... Args>
+	Component& emplace(Entity e, Args &&...) {
+		return insert(e);
+	};
+	template<typename... Args>
+	Component& emplace_with_duplicates(Entity e, Args &&...) {
+		return insert(e, {}, false);
+	};
+
+	Component& get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		(void)e;
+		return instance;
+	}
+
+	Component* find(Entity e) {
+		return has(e) ? &instance : nullptr;
+	}
+
+	// Hides EntitySet::has, the bit is only set while the entity of that index is contained
+	bool has(Entity e) const
+	{
+		return test(e.index()) && e.is_alive();
+	}
+
+	void remove(Entity e)
+	{
+		if (!has(e))
+			return;
+		const unsigned int slot = sparse_index.find(e.index());
+		entities[slot] = entities.back();
+		sparse_index.set(entities.back().index(), slot);
+		sparse_index.reset(e.index());
+		entities.pop_back();
+		bits[e.index() >> 6] &= ~(uint64_t(1) << (e.index() & 63));
+		remove_signature(e);
+	}
+
+	void clear()
+	{
+		for (Entity e : entities)
+		{
+			sparse_index.reset(e.index());
+			remove_signature(e);
+		}
+		std::fill(bits.begin(), bits.end(), 0);
+		entities.clear();
+	}
+
+	template <class Compare>
+	void sort(Compare comparisonFunction)
+	{
+		std::sort(entities.begin(), entities.end(), comparisonFunction);
+		for (unsigned int i = 0; i < entities.size(); i++)
+			sparse_index.set(entities[i].index(), i);
+	}
+};
+
+template <typename Component>
+Component ComponentContainer<Component, true>::instance;
+
+// Joins containers on their entities: visits every entity that has all of the included
+// components and none of the excluded ones, handing out references to all included components.
+// Iteration is driven by the smallest included container, unless another one is chosen with
+// use() to keep its order. Adding or removing components of the visited containers while
+// iterating is not supported.
+template <typename... Components>
+class View
+{
+	std::tuple<ComponentContainer<Components>*...> containers;
+	std::vector<const EntitySet*> excluded;
+	const EntitySet* driver = nullptr;
+	const SignatureStore* signatures = nullptr;
+	Signature all_of = 0;
+	Signature none_of = 0;
+
+	template <size_t... I>
+	const EntitySet* smallest(std::index_sequence<I...>) const
+	{
+		const EntitySet* sets[] = { std::get<I>(containers)... };
+		return *std::min_element(std::begin(sets), std::end(sets),
+			[](const EntitySet* a, const EntitySet* b) { return a->size() < b->size(); });
+	}
+
+	template <typename Func, size_t... I>
+	void visit(Entity e, Func& func, std::index_sequence<I...>)
+	{
+		auto found = std::make_tuple(std::get<I>(containers)->find(e)...);
+		bool all_found = true;
+		(void)std::initializer_list<int>{ (all_found = all_found && std::get<I>(found) != nullptr, 0)... };
+		if (!all_found)
+			return;
+		if (signatures)
+		{
+			const Signature signature = signatures->get(e.index());
+			if ((signature & all_of) != all_of || (signature & none_of) != 0)
+				return;
+		}
+		for (const EntitySet* set : excluded)
+			if (set->has(e))
+				return;
+		func(e, *std::get<I>(found)...);
+	}
+
+public:
+	View(ComponentContainer<Components>&... included) : containers(&included...)
+	{
+		driver = smallest(std::index_sequence_for<Components...>{});
+	}
+
+	// Skip entities that are contained in any of the given containers
+	template <typename... Sets>
+	View& exclude(Sets&... sets)
+	{
+		(void)std::initializer_list<int>{ (excluded.push_back(&sets), 0)... };
+		return *this;
+	}
+
+	// Only visit entities whose signature has all bits of 'all' and none of 'none'
+	// A single signature lookup replaces probing one container per required or excluded bit
+	View& filter(const SignatureStore& store, Signature all, Signature none)
+	{
+		signatures = &store;
+		all_of |= all;
+		none_of |= none;
+		return *this;
+	}
+
+	// Drive the iteration from the given container, visiting entities in its order
+	View& use(const EntitySet& set)
+	{
+		driver = &set;
+		return *this;
+	}
+
+	// Calls func(Entity, Components&...) for every matching entity
+	template <typename Func>
+	void each(Func func)
+	{
+		for (size_t i = 0; i < driver->entities.size(); i++)
+			visit(driver->entities[i], func, std::index_sequence_for<Components...>{});
+	}
+};
+
+// Registry key for a container that stores 'Component' under a name of its own. It is needed when
+// the same component type lives in more than one container, e.g. the hands of player and boss:
+//   struct PlayerHand : Tagged<Hand> {};
+template <typename Component>
+struct Tagged
+{
+	using component_type = Component;
+};
+
+// The component type stored under a registry key: the key itself, unless it is a Tagged name
+template <typename Key, typename = void>
+struct component_of { using type = Key; };
+template <typename Key>
+struct component_of<Key, std::void_t<typename Key::component_type>> { using type = typename Key::component_type; };
+template <typename Key>
+using component_of_t = typename component_of<Key>::type;
+
+// Keys of the containers a view skips, see Registry::view
+template <typename... Keys>
+struct Exclude {};
+template <typename... Keys>
+constexpr Exclude<Keys...> exclude{};
+
+// A registry holding one container per key of the type list. Everything that loops over all
+// containers is unrolled at compile time, so there is no virtual dispatch and adding a
+// component only means adding its key to the list.
+// Each container owns one bit of the entity signatures, so an entity knows which containers
+// it is in without asking all of them.
+template <typename... Keys>
+class Registry
+{
+	static_assert(sizeof...(Keys) <= sizeof(Signature) * 8, "Too many components for the signature");
+
+	std::tuple<ComponentContainer<component_of_t<Keys>>...> containers;
+	SignatureStore signatures;
+
+	template <typename Key>
+	static constexpr size_t index_of()
+	{
+		constexpr bool matches[] = { std::is_same<Key, Keys>::value... };
+		for (size_t i = 0; i < sizeof...(Keys); i++)
+			if (matches[i])
+				return i;
+		return sizeof...(Keys);
+	}
+
+	template <size_t... I>
+	void list_all(std::index_sequence<I...>)
+	{
+		((std::get<I>(containers).size() > 0 ?
+			printf("%4d components of type %s\n", (int)std::get<I>(containers).size(), typeid(Keys).name()) : 0), ...);
+	}
+
+	template <size_t... I>
+	void track_all(std::index_sequence<I...>)
+	{
+		(std::get<I>(containers).track(signatures, Signature(1) << I), ...);
+	}
+
+public:
+	Registry()
+	{
+		track_all(std::index_sequence_for<Keys...>{});
+	}
+	// The containers point to the signatures of this registry
+	Registry(const Registry&) = delete;
+	Registry& operator=(const Registry&) = delete;
+
+	// The signature bits of the given keys
+	template <typename... MaskKeys>
+	static constexpr Signature mask()
+	{
+		return (Signature(0) | ... | (Signature(1) << index_of<MaskKeys>()));
+	}
+
+	// Signature of the containers the entity is in, 0 for destroyed entities
+	Signature signature_of(Entity e) const
+	{
+		return e.is_alive() ? signatures.get(e.index()) : 0;
+	}
+
+	// Does the entity have all of / none of the components of the given keys?
+	template <typename... MaskKeys>
+	bool has_all(Entity e) const
+	{
+		constexpr Signature bits = mask<MaskKeys...>();
+		return (signature_of(e) & bits) == bits;
+	}
+	template <typename... MaskKeys>
+	bool has_none(Entity e) const
+	{
+		return (signature_of(e) & mask<MaskKeys...>()) == 0;
+	}
+
+	// The container stored under a key
+	template <typename Key>
+	ComponentContainer<component_of_t<Key>>& get()
+	{
+		static_assert(index_of<Key>() < sizeof...(Keys), "Key is not part of the registry");
+		return std::get<index_of<Key>()>(containers);
+	}
+
+	// Join the containers of the given keys, see View
+	// e.g. view<Motion, RenderRequest>() or view<Motion>(exclude<Traversable>)
+	template <typename... ViewKeys, typename... ExcludedKeys>
+	View<component_of_t<ViewKeys>...> view(Exclude<ExcludedKeys...> = {})
+	{
+		View<component_of_t<ViewKeys>...> result(get<ViewKeys>()...);
+		result.filter(signatures, 0, mask<ExcludedKeys...>());
+		return result;
+	}
+
+	// Destroys every entity that has a component, like remove_all_components_of() on all of them
+	void clear_all_components() {
+		std::apply([](auto&... container) {
+			(std::for_each(container.entities.begin(), container.entities.end(), Entity::destroy), ...);
+			(container.clear(), ...);
+		}, containers);
+	}
+
+	void list_all_components() {
+		printf("Debug info on all registry entries:\n");
+		list_all(std::index_sequence_for<Keys...>{});
+	}
+
+	void list_all_components_of(Entity e) {
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		static const char* const names[] = { typeid(Keys).name()... };
+		for (Signature signature = signature_of(e); signature != 0; signature &= signature - 1)
+		{
+			unsigned int bit = 0;
+			while (!(signature & (Signature(1) << bit)))
+				bit++;
+			printf("type %s\n", names[bit]);
+		}
+	}
+
+	// Removing all components destroys the entity, its slot is then free for re-use
+	// Only the containers in the signature of the entity are touched
+	void remove_all_components_of(Entity e) {
+		const Signature signature = signature_of(e);
+		((signature & mask<Keys>() ? get<Keys>().remove(e) : void()), ...);
+		Entity::destroy(e);
 	}
 };
@@ -4,127 +4,123 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 
-class ECSRegistry
-{
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
-
-public:
-	// Manually created list of all components this game has
-	ComponentContainer<Player> players;
-	ComponentContainer<Npc> npcs;
-	ComponentContainer<Enemy> subBosses;
-	ComponentContainer<Enemy> bosses;
-	ComponentContainer<Biome> biomes;
-	ComponentContainer<Hand> playerHands;
-	ComponentContainer<Hand> bossHands;
-	ComponentContainer<Deck> playerDecks;
-	ComponentContainer<Deck> bossDecks;
-	ComponentContainer<Play> playerPlays;
-	ComponentContainer<Play> bossPlays;
-	ComponentContainer<Generator> generators;
-	ComponentContainer<BoardUI> boardPlayers;
-	ComponentContainer<BoardUI> boardBosses;
-	ComponentContainer<BoardUI> boardModes;
-	ComponentContainer<BoardUI> boardPlayerBars;
-	ComponentContainer<BoardUI> boardOpponentBars;
-	ComponentContainer<MenuUI> menuStarts;
-	ComponentContainer<MenuUI> menuContinues;
-	ComponentContainer<MenuUI> menuInstructions;
-	ComponentContainer<InstructionsUI> instructionsClose;
-	ComponentContainer<StoryUI> Close;
-	ComponentContainer<Health> healthComponents;
-	ComponentContainer<Damage> damageComponents;
-	ComponentContainer<Timer> timer;
-	ComponentContainer<Interactable> interactables;
-	ComponentContainer<Traversable> traversables;
-	ComponentContainer<Lootable> lootables;
-	ComponentContainer<Tier> tiers;
-	ComponentContainer<Motion> motions;
-	ComponentContainer<Battle> battles;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Animation> animations;
-	ComponentContainer<Progression> progressions;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<ScreenTimer> screenTimers;
-	ComponentContainer<CardAppearTimer> cardAppearTimers;
-	ComponentContainer<BossModeTimer> bossModeTimers;
-	ComponentContainer<Mesh*> meshPtrs;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<vec3> colors;
-
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
-	ECSRegistry()
-	{	
-		registry_list.push_back(&players);
-		registry_list.push_back(&npcs);
-		registry_list.push_back(&subBosses);
-		registry_list.push_back(&bosses);
-		registry_list.push_back(&biomes);
-		registry_list.push_back(&playerHands);
-		registry_list.push_back(&bossHands);
-		registry_list.push_back(&playerDecks);
-		registry_list.push_back(&bossDecks);
-		registry_list.push_back(&playerPlays);
-		registry_list.push_back(&bossPlays);
-		registry_list.push_back(&generators);
-		registry_list.push_back(&boardPlayers);
-		registry_list.push_back(&boardBosses);
-		registry_list.push_back(&boardModes);
-		registry_list.push_back(&boardPlayerBars);
-		registry_list.push_back(&boardOpponentBars);
-		registry_list.push_back(&menuStarts);
-		registry_list.push_back(&menuContinues);
-		registry_list.push_back(&menuInstructions);
-		registry_list.push_back(&instructionsClose);
-		registry_list.push_back(&Close);
-		registry_list.push_back(&healthComponents);
-		registry_list.push_back(&damageComponents);
-		registry_list.push_back(&timer);
-		registry_list.push_back(&interactables);
-		registry_list.push_back(&traversables);
-		registry_list.push_back(&lootables);
-		registry_list.push_back(&tiers);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&battles);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&progressions);
-		registry_list.push_back(&animations);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&screenTimers);
-		registry_list.push_back(&cardAppearTimers);
-		registry_list.push_back(&bossModeTimers);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&colors);
-	}
+// Names for the component types that are stored in more than one container
+struct SubBoss : Tagged<Enemy> {};
+struct Boss : Tagged<Enemy> {};
+struct PlayerHand : Tagged<Hand> {};
+struct BossHand : Tagged<Hand> {};
+struct PlayerDeck : Tagged<Deck> {};
+struct BossDeck : Tagged<Deck> {};
+struct PlayerPlay : Tagged<Play> {};
+struct BossPlay : Tagged<Play> {};
+struct BoardPlayer : Tagged<BoardUI> {};
+struct BoardBoss : Tagged<BoardUI> {};
+struct BoardMode : Tagged<BoardUI> {};
+struct BoardPlayerBar : Tagged<BoardUI> {};
+struct BoardOpponentBar : Tagged<BoardUI> {};
+struct MenuStart : Tagged<MenuUI> {};
+struct MenuContinue : Tagged<MenuUI> {};
+struct MenuInstruction : Tagged<MenuUI> {};
 
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
-	}
+// List of all components this game has; a new component only needs to be added here
+// (and given a name below if systems refer to its container directly)
+using GameRegistry = Registry<
+	Player,
+	Npc,
+	SubBoss,
+	Boss,
+	Biome,
+	PlayerHand,
+	BossHand,
+	PlayerDeck,
+	BossDeck,
+	PlayerPlay,
+	BossPlay,
+	Generator,
+	BoardPlayer,
+	BoardBoss,
+	BoardMode,
+	BoardPlayerBar,
+	BoardOpponentBar,
+	MenuStart,
+	MenuContinue,
+	MenuInstruction,
+	InstructionsUI,
+	StoryUI,
+	Health,
+	Damage,
+	Timer,
+	Interactable,
+	Traversable,
+	TileMap,
+	Lootable,
+	Tier,
+	Motion,
+	NavigationObstacle,
+	Battle,
+	Collision,
+	Progression,
+	Animation,
+	ScreenState,
+	ScreenTimer,
+	CardAppearTimer,
+	BossModeTimer,
+	Mesh*,
+	RenderRequest,
+	vec3>;
 
-	void list_all_components() {
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
-
-	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
-	}
+class ECSRegistry : public GameRegistry
+{
+public:
+	// Named references to the containers
+	ComponentContainer<Player>& players = get<Player>();
+	ComponentContainer<Npc>& npcs = get<Npc>();
+	ComponentContainer<Enemy>& subBosses = get<SubBoss>();
+	ComponentContainer<Enemy>& bosses = get<Boss>();
+	ComponentContainer<Biome>& biomes = get<Biome>();
+	ComponentContainer<Hand>& playerHands = get<PlayerHand>();
+	ComponentContainer<Hand>& bossHands = get<BossHand>();
+	ComponentContainer<Deck>& playerDecks = get<PlayerDeck>();
+	ComponentContainer<Deck>& bossDecks = get<BossDeck>();
+	ComponentContainer<Play>& playerPlays = get<PlayerPlay>();
+	ComponentContainer<Play>& bossPlays = get<BossPlay>();
+	ComponentContainer<Generator>& generators = get<Generator>();
+	ComponentContainer<BoardUI>& boardPlayers = get<BoardPlayer>();
+	ComponentContainer<BoardUI>& boardBosses = get<BoardBoss>();
+	ComponentContainer<BoardUI>& boardModes = get<BoardMode>();
+	ComponentContainer<BoardUI>& boardPlayerBars = get<BoardPlayerBar>();
+	ComponentContainer<BoardUI>& boardOpponentBars = get<BoardOpponentBar>();
+	ComponentContainer<MenuUI>& menuStarts = get<MenuStart>();
+	ComponentContainer<MenuUI>& menuContinues = get<MenuContinue>();
+	ComponentContainer<MenuUI>& menuInstructions = get<MenuInstruction>();
+	ComponentContainer<InstructionsUI>& instructionsClose = get<InstructionsUI>();
+	ComponentContainer<StoryUI>& Close = get<StoryUI>();
+	ComponentContainer<Health>& healthComponents = get<Health>();
+	ComponentContainer<Damage>& damageComponents = get<Damage>();
+	ComponentContainer<Timer>& timer = get<Timer>();
+	ComponentContainer<Interactable>& interactables = get<Interactable>();
+	ComponentContainer<Traversable>& traversables = get<Traversable>();
+	ComponentContainer<TileMap>& tileMaps = get<TileMap>();
+	ComponentContainer<Lootable>& lootables = get<Lootable>();
+	ComponentContainer<Tier>& tiers = get<Tier>();
+	ComponentContainer<Motion>& motions = get<Motion>();
+	ComponentContainer<NavigationObstacle>& navigationObstacles = get<NavigationObstacle>();
+	ComponentContainer<Battle>& battles = get<Battle>();
+	ComponentContainer<Collision>& collisions = get<Collision>();
+	ComponentContainer<Animation>& animations = get<Animation>();
+	ComponentContainer<Progression>& progressions = get<Progression>();
+	ComponentContainer<ScreenState>& screenStates = get<ScreenState>();
+	ComponentContainer<ScreenTimer>& screenTimers = get<ScreenTimer>();
+	ComponentContainer<CardAppearTimer>& cardAppearTimers = get<CardAppearTimer>();
+	ComponentContainer<BossModeTimer>& bossModeTimers = get<BossModeTimer>();
+	ComponentContainer<Mesh*>& meshPtrs = get<Mesh*>();
+	ComponentContainer<RenderRequest>& renderRequests = get<RenderRequest>();
+	ComponentContainer<vec3>& colors = get<vec3>();
 
-	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
-	}
+	// Non-copyable, the references above point into this registry
+	ECSRegistry() = default;
+	ECSRegistry(const ECSRegistry&) = delete;
+	ECSRegistry& operator=(const ECSRegistry&) = delete;
 };
 
 extern ECSRegistry registry;
\ No newline at end of file
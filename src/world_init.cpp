@@ -3,7 +3,7 @@
 
 Entity createMenu(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -12,6 +12,7 @@ Entity createMenu(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -22,14 +23,15 @@ Entity createMenu(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::MENU,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::BACKGROUND });
 
 	return entity;
 }
 
 Entity createMenuStart(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -38,6 +40,7 @@ Entity createMenuStart(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -50,14 +53,15 @@ Entity createMenuStart(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::MENU_START,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createMenuContinue(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -66,6 +70,7 @@ Entity createMenuContinue(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -78,14 +83,15 @@ Entity createMenuContinue(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::MENU_CONTINUE,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createMenuInstructions(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -94,6 +100,7 @@ Entity createMenuInstructions(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -106,14 +113,15 @@ Entity createMenuInstructions(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::MENU_INSTRUCTIONS,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createInstructionsClose(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -122,6 +130,7 @@ Entity createInstructionsClose(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -134,14 +143,15 @@ Entity createInstructionsClose(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::INSTRUCTIONS_CLOSE,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::OVERLAY_UI });
 
 	return entity;
 }
 
 Entity createClose(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -150,6 +160,7 @@ Entity createClose(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -162,14 +173,15 @@ Entity createClose(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::CLOSE,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::OVERLAY_UI });
 
 	return entity;
 }
 
 Entity createGameOver(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -178,6 +190,7 @@ Entity createGameOver(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -188,14 +201,15 @@ Entity createGameOver(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::GAMEOVER,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::OVERLAY });
 
 	return entity;
 }
 
 Entity createInstructions(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -204,6 +218,7 @@ Entity createInstructions(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -214,14 +229,15 @@ Entity createInstructions(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::INSTRUCTIONS,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::OVERLAY });
 
 	return entity;
 }
 
 Entity createCharacter(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -230,6 +246,7 @@ Entity createCharacter(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -246,14 +263,15 @@ Entity createCharacter(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::CHARACTER_DOWN,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PLAYER });
 
 	return entity;
 }
 
 Entity createNpc(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -264,6 +282,7 @@ Entity createNpc(RenderSystem* renderer, vec2 position)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ NPC_BB_WIDTH, NPC_BB_HEIGHT });
@@ -274,14 +293,15 @@ Entity createNpc(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::NPC,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::ACTOR });
 
 	return entity;
 }
 
 Entity createStory(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -290,6 +310,7 @@ Entity createStory(RenderSystem* renderer, vec2 position)
 	// Setting initial motion values
 	Motion& motion = registry.motions.emplace(entity);
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 
@@ -300,7 +321,8 @@ Entity createStory(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::STORY,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::OVERLAY });
 
 	return entity;
 }
@@ -308,7 +330,7 @@ Entity createStory(RenderSystem* renderer, vec2 position)
 
 Entity createSubBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -319,6 +341,7 @@ Entity createSubBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 	motion.angle = 0.f;
 	motion.velocity = { 0, 100.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ SUBBOSS_BB_WIDTH, SUBBOSS_BB_HEIGHT });
@@ -351,14 +374,15 @@ Entity createSubBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::ANIMATED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::ACTOR });
 
 	return entity;
 }
 
 Entity createBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -369,6 +393,7 @@ Entity createBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 	motion.angle = 0.f;
 	motion.velocity = { 0, 100.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ BOSS_BB_WIDTH, BOSS_BB_HEIGHT });
@@ -405,14 +430,15 @@ Entity createBoss(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::ANIMATED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::ACTOR });
 
 	return entity;
 }
 
 Entity createChest(RenderSystem* renderer, vec2 position, TIER_ID used_tier)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -423,6 +449,7 @@ Entity createChest(RenderSystem* renderer, vec2 position, TIER_ID used_tier)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ CHEST_BB_WIDTH, CHEST_BB_HEIGHT });
@@ -452,14 +479,15 @@ Entity createChest(RenderSystem* renderer, vec2 position, TIER_ID used_tier)
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
 
 Entity createCardPlacement(RenderSystem* renderer, vec2 position, bool is_for_player)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -470,6 +498,7 @@ Entity createCardPlacement(RenderSystem* renderer, vec2 position, bool is_for_pl
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ CARD_BB_WIDTH, CARD_BB_HEIGHT });
@@ -491,14 +520,15 @@ Entity createCardPlacement(RenderSystem* renderer, vec2 position, bool is_for_pl
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
 
 Entity createCardGenerator(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -509,6 +539,7 @@ Entity createCardGenerator(RenderSystem* renderer, vec2 position)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ CARD_BB_WIDTH, CARD_BB_HEIGHT });
@@ -519,7 +550,8 @@ Entity createCardGenerator(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::BOARD_GENERATOR,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
@@ -527,7 +559,7 @@ Entity createCardGenerator(RenderSystem* renderer, vec2 position)
 Entity createCard(RenderSystem* renderer, vec2 position, BIOME_ID used_biome,
 	int current_health, int max_health, int damage_output)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -538,6 +570,7 @@ Entity createCard(RenderSystem* renderer, vec2 position, BIOME_ID used_biome,
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ CARD_BB_WIDTH, CARD_BB_HEIGHT });
@@ -573,14 +606,15 @@ Entity createCard(RenderSystem* renderer, vec2 position, BIOME_ID used_biome,
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::CARD,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::CARD });
 
 	return entity;
 }
 
 Entity loadCard(RenderSystem* renderer, int current_health, int max_health, int damage_output)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -591,6 +625,7 @@ Entity loadCard(RenderSystem* renderer, int current_health, int max_health, int
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = { 0.f - CARD_BB_WIDTH, 0.f - CARD_BB_HEIGHT };
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ CARD_BB_WIDTH, CARD_BB_HEIGHT });
@@ -610,7 +645,7 @@ Entity loadCard(RenderSystem* renderer, int current_health, int max_health, int
 
 Entity createModeUI(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -621,6 +656,7 @@ Entity createModeUI(RenderSystem* renderer, vec2 position)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ BOARD_MODE_BB_WIDTH, BOARD_MODE_BB_HEIGHT });
@@ -631,134 +667,88 @@ Entity createModeUI(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::BOARD_SELECT,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createBarUI(vec2 position, vec2 scale)
 {
-	Entity entity = Entity();
+	Entity entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT,
 		  EFFECT_ASSET_ID::EGG,
-		  GEOMETRY_BUFFER_ID::DEBUG_LINE });
+		  GEOMETRY_BUFFER_ID::DEBUG_LINE,
+		  RENDER_LAYER::UI });
 
 	// Create motion
 	Motion& motion = registry.motions.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
+	motion.previous_position = motion.position;
 	motion.scale = scale;
 
 	return entity;
 }
 
-Entity createPath(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
+Entity createTileMap(const std::vector<int>& tiles, BIOME_ID used_biome)
 {
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0.f, 0.f };
-	motion.position = position;
-
-	// Setting initial values
-	motion.scale = vec2({ TILE_BB_WIDTH, TILE_BB_HEIGHT });
-
-	// Create an (empty) Path component to be able to refer to all tiles representing paths
-	registry.traversables.emplace(entity);
-
-	// Set texture to be used
-	TEXTURE_ASSET_ID used_texture;
+	auto entity = Entity::create();
+
+	TileMap& tile_map = registry.tileMaps.emplace(entity);
+	tile_map.columns = (int)ceil(window_width_px / TILE_BB_WIDTH);
+	tile_map.rows = (int)ceil(window_height_px / TILE_BB_HEIGHT);
+	tile_map.tile_size = { TILE_BB_WIDTH, TILE_BB_HEIGHT };
+	assert(tiles.size() == (size_t)(tile_map.columns * tile_map.rows));
+	tile_map.walls.resize(tiles.size());
+	for (size_t i = 0; i < tiles.size(); i++)
+		tile_map.walls[i] = tiles[i] == (int)TILES::WALL;
+
+	// Set textures to be used
 	switch (used_biome)
 	{
 	default:
 	case BIOME_ID::HUB:
-		used_texture = TEXTURE_ASSET_ID::BIOME_HUB_PATH;
+		tile_map.path_texture = TEXTURE_ASSET_ID::BIOME_HUB_PATH;
+		tile_map.wall_texture = TEXTURE_ASSET_ID::BIOME_HUB_WALL;
 		break;
 	case BIOME_ID::FROST:
-		used_texture = TEXTURE_ASSET_ID::BIOME_FROST_PATH;
+		tile_map.path_texture = TEXTURE_ASSET_ID::BIOME_FROST_PATH;
+		tile_map.wall_texture = TEXTURE_ASSET_ID::BIOME_FROST_WALL;
 		break;
 	case BIOME_ID::BEACH:
-		used_texture = TEXTURE_ASSET_ID::BIOME_BEACH_PATH;
+		tile_map.path_texture = TEXTURE_ASSET_ID::BIOME_BEACH_PATH;
+		tile_map.wall_texture = TEXTURE_ASSET_ID::BIOME_BEACH_WALL;
 		break;
 	case BIOME_ID::LAVA:
-		used_texture = TEXTURE_ASSET_ID::BIOME_LAVA_PATH;
+		tile_map.path_texture = TEXTURE_ASSET_ID::BIOME_LAVA_PATH;
+		tile_map.wall_texture = TEXTURE_ASSET_ID::BIOME_LAVA_WALL;
 		break;
 	case BIOME_ID::JUNGLE:
-		used_texture = TEXTURE_ASSET_ID::BIOME_JUNGLE_PATH;
+		tile_map.path_texture = TEXTURE_ASSET_ID::BIOME_JUNGLE_PATH;
+		tile_map.wall_texture = TEXTURE_ASSET_ID::BIOME_JUNGLE_WALL;
 		break;
 	}
 
+	// The tile map has no motion, it always covers the window
 	registry.renderRequests.insert(
 		entity,
-		{ used_texture,
-		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
-}
-
-Entity createWall(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
-{
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the motion
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0.f, 0.f };
-	motion.position = position;
-
-	// Setting initial values
-	motion.scale = vec2({ TILE_BB_WIDTH, TILE_BB_HEIGHT });
-
-	// Set texture to be used
-	TEXTURE_ASSET_ID used_texture;
-	switch (used_biome)
-	{
-	default:
-	case BIOME_ID::HUB:
-		used_texture = TEXTURE_ASSET_ID::BIOME_HUB_WALL;
-		break;
-	case BIOME_ID::FROST:
-		used_texture = TEXTURE_ASSET_ID::BIOME_FROST_WALL;
-		break;
-	case BIOME_ID::BEACH:
-		used_texture = TEXTURE_ASSET_ID::BIOME_BEACH_WALL;
-		break;
-	case BIOME_ID::LAVA:
-		used_texture = TEXTURE_ASSET_ID::BIOME_LAVA_WALL;
-		break;
-	case BIOME_ID::JUNGLE:
-		used_texture = TEXTURE_ASSET_ID::BIOME_JUNGLE_WALL;
-		break;
-	}
-
-	registry.renderRequests.insert(
-		entity,
-		{ used_texture,
-		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		{ tile_map.path_texture,
+		  EFFECT_ASSET_ID::TILEMAP,
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::TILE });
 
 	return entity;
 }
 
 Entity createTree(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID used_texture)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -769,6 +759,7 @@ Entity createTree(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID used_t
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ TREE_BB_WIDTH, TREE_BB_HEIGHT });
@@ -778,14 +769,15 @@ Entity createTree(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID used_t
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
 
 Entity createTimer(RenderSystem* renderer, vec2 position, int currentFrame, float updateTime)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -796,6 +788,7 @@ Entity createTimer(RenderSystem* renderer, vec2 position, int currentFrame, floa
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ 50, 50 });
@@ -814,14 +807,15 @@ Entity createTimer(RenderSystem* renderer, vec2 position, int currentFrame, floa
 		entity,
 		{ TEXTURE_ASSET_ID::TIMER,
 		  EFFECT_ASSET_ID::ANIMATED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createHealth(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -832,6 +826,7 @@ Entity createHealth(RenderSystem* renderer, vec2 position)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ ITEM_BB_WIDTH, ITEM_BB_HEIGHT });
@@ -850,14 +845,15 @@ Entity createHealth(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::ITEM_HEALTH,
 		  EFFECT_ASSET_ID::ANIMATED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
 
 Entity createDamage(RenderSystem* renderer, vec2 position)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -868,6 +864,7 @@ Entity createDamage(RenderSystem* renderer, vec2 position)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ ITEM_BB_WIDTH, ITEM_BB_HEIGHT });
@@ -885,14 +882,15 @@ Entity createDamage(RenderSystem* renderer, vec2 position)
 		entity,
 		{ TEXTURE_ASSET_ID::ITEM_DAMAGE,
 		  EFFECT_ASSET_ID::ANIMATED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
 
 Entity createBiome(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -903,6 +901,7 @@ Entity createBiome(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
+	motion.previous_position = motion.position;
 
 	// Setting initial values
 	motion.scale = vec2({ TILE_BB_WIDTH, TILE_BB_HEIGHT });
@@ -937,29 +936,8 @@ Entity createBiome(RenderSystem* renderer, vec2 position, BIOME_ID used_biome)
 		entity,
 		{ used_texture,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PROP });
 
 	return entity;
 }
-
-Entity createLine(vec2 position, vec2 scale)
-{
-	Entity entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::TEXTURE_COUNT,
-		  EFFECT_ASSET_ID::EGG,
-		  GEOMETRY_BUFFER_ID::DEBUG_LINE });
-
-	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0, 0 };
-	motion.position = position;
-	motion.scale = scale;
-
-	registry.debugComponents.emplace(entity);
-	return entity;
-}
\ No newline at end of file
@@ -78,9 +78,8 @@ Entity loadCard(RenderSystem* renderer, int current_health, int max_health, int
 // the board
 Entity createModeUI(RenderSystem* renderer, vec2 position);
 Entity createBarUI(vec2 position, vec2 size);
-// the tiles
-Entity createPath(RenderSystem* renderer, vec2 position, BIOME_ID used_biome);
-Entity createWall(RenderSystem* renderer, vec2 position, BIOME_ID used_biome);
+// the tiles, a grid of TILES covering the window
+Entity createTileMap(const std::vector<int>& tiles, BIOME_ID used_biome);
 // the non-interactable objects
 Entity createTree(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID used_texture);
 Entity createTimer(RenderSystem* renderer, vec2 position, int currentFrame, float updateTime);
@@ -88,6 +87,4 @@ Entity createTimer(RenderSystem* renderer, vec2 position, int currentFrame, floa
 Entity createHealth(RenderSystem* renderer, vec2 position);
 Entity createDamage(RenderSystem* renderer, vec2 position);
 // the biomes
-Entity createBiome(RenderSystem* renderer, vec2 position, BIOME_ID used_biome);
-// a red line for debugging purposes
-Entity createLine(vec2 position, vec2 size);
\ No newline at end of file
+Entity createBiome(RenderSystem* renderer, vec2 position, BIOME_ID used_biome);
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "physics_system.hpp"
 #include "ai_system.hpp"
 #include "battle_system.hpp"
+#include "asset_pack.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
 
 // stlib
 #include <cassert>
@@ -18,6 +21,9 @@ const size_t MAX_SUBBOSSES = 4;
 const size_t MAX_BOSS = 1;
 const size_t MAX_ITEMS = 3;
 const int WorldSystem::GRANULARITY = 5; //size of the nodes the map is divided into, for pathfinding purposes.
+const int WorldSystem::NAVIGATION_COLUMNS = (window_width_px + GRANULARITY - 1) / GRANULARITY;
+const int WorldSystem::NAVIGATION_ROWS = (window_height_px + GRANULARITY - 1) / GRANULARITY;
+const int WorldSystem::NAVIGATION_ROWS_PER_JOB = 16;
 
 // Map configuration
 const int NUM_TILES_ACROSS = ceil(window_width_px / TILE_BB_WIDTH);
@@ -69,6 +75,13 @@ WorldSystem::WorldSystem()
 }
 
 WorldSystem::~WorldSystem() {
+	// Destroy all created components
+	registry.clear_all_components();
+
+#ifndef IOLS_HEADLESS
+	if (is_headless())
+		return;
+
 	// Destroy music components
 	if (background_music != nullptr)
 		Mix_FreeMusic(background_music);
@@ -76,13 +89,13 @@ WorldSystem::~WorldSystem() {
 		Mix_FreeChunk(character_teleport_sound);
 	Mix_CloseAudio();
 
-	// Destroy all created components
-	registry.clear_all_components();
-
 	// Close the window
 	glfwDestroyWindow(window);
+#endif
 }
 
+#ifndef IOLS_HEADLESS
+
 // Debugging
 namespace {
 	void glfw_err_cb(int error, const char* desc) {
@@ -90,6 +103,23 @@ namespace {
 	}
 }
 
+// Audio is read from the asset pack if it is packed, the mapping outlives the music streaming from it
+namespace {
+	Mix_Music* load_music(const std::string& path) {
+		const AssetPackEntry* packed = asset_pack.find(path);
+		if (packed && packed->kind == ASSET_KIND::AUDIO)
+			return Mix_LoadMUS_RW(SDL_RWFromConstMem(asset_pack.contents(*packed), (int)packed->size), 1);
+		return Mix_LoadMUS(path.c_str());
+	}
+
+	Mix_Chunk* load_sound(const std::string& path) {
+		const AssetPackEntry* packed = asset_pack.find(path);
+		if (packed && packed->kind == ASSET_KIND::AUDIO)
+			return Mix_LoadWAV_RW(SDL_RWFromConstMem(asset_pack.contents(*packed), (int)packed->size), 1);
+		return Mix_LoadWAV(path.c_str());
+	}
+}
+
 // World initialization
 // Note, this has a lot of OpenGL specific things, could be moved to the renderer
 GLFWwindow* WorldSystem::create_window() {
@@ -143,11 +173,11 @@ GLFWwindow* WorldSystem::create_window() {
 		return nullptr;
 	}
 
-	background_music = Mix_LoadMUS(audio_path("forest.wav").c_str());
-	character_teleport_sound = Mix_LoadWAV(audio_path("character_teleport.wav").c_str());
-	chest_open_sound = Mix_LoadWAV(audio_path("chest_open.wav").c_str());
-	item_acquire_health_sound = Mix_LoadWAV(audio_path("item_acquire_health.wav").c_str());
-	item_acquire_damage_sound = Mix_LoadWAV(audio_path("item_acquire_damage.wav").c_str());
+	background_music = load_music(audio_path("forest.wav"));
+	character_teleport_sound = load_sound(audio_path("character_teleport.wav"));
+	chest_open_sound = load_sound(audio_path("chest_open.wav"));
+	item_acquire_health_sound = load_sound(audio_path("item_acquire_health.wav"));
+	item_acquire_damage_sound = load_sound(audio_path("item_acquire_damage.wav"));
 
 	if (background_music == nullptr || character_teleport_sound == nullptr ||
 		chest_open_sound == nullptr || item_acquire_health_sound == nullptr ||
@@ -163,12 +193,24 @@ GLFWwindow* WorldSystem::create_window() {
 
 	return window;
 }
+#else
+// Headless builds link neither GLFW nor SDL
+GLFWwindow* WorldSystem::create_window() {
+	fprintf(stderr, "Headless build, there is no window\n");
+	return nullptr;
+}
+#endif
 
-void WorldSystem::init(RenderSystem* renderer_arg) {
+void WorldSystem::init(RenderSystem* renderer_arg, const TaskScheduler* scheduler_arg) {
 	this->renderer = renderer_arg;
+	this->scheduler = scheduler_arg;
+#ifndef IOLS_HEADLESS
 	// Playing background music indefinitely
-	Mix_PlayMusic(background_music, -1);
-	fprintf(stderr, "Loaded music\n");
+	if (!is_headless()) {
+		Mix_PlayMusic(background_music, -1);
+		fprintf(stderr, "Loaded music\n");
+	}
+#endif
 
 	// Set all states to default
 	restart_game();
@@ -176,14 +218,23 @@ void WorldSystem::init(RenderSystem* renderer_arg) {
 
 // Update our game world
 bool WorldSystem::step(float elapsed_ms_since_last_update) {
+	PROFILE_SCOPE("WorldSystem::step");
 	// Updating window title
 	std::stringstream title_ss;
 	title_ss << "Island of Lost Souls";
-	glfwSetWindowTitle(window, title_ss.str().c_str());
+	if (debugging.in_debug_mode)
+		title_ss << " | Draw calls: " << renderer->get_draw_calls()
+			<< " | GL binds issued: " << renderer->get_gl_state().issued
+			<< ", elided: " << renderer->get_gl_state().elided
+			<< " | Task time / tick time: " << scheduler->get_parallelism()
+			<< " on " << job_system.get_thread_count() << " threads";
+#ifndef IOLS_HEADLESS
+	if (!is_headless())
+		glfwSetWindowTitle(window, title_ss.str().c_str());
+#endif
 
 	// Remove debug info from the last step
-	while (registry.debugComponents.entities.size() > 0)
-		registry.remove_all_components_of(registry.debugComponents.entities.back());
+	debug_draw.clear();
 
 	// The screen and its state
 	assert(registry.screenStates.components.size() <= 1);
@@ -216,20 +267,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			render_request_registry.get(player_character).used_texture = used_texture;
 		}
 
-		// Processing the animation state
+		// The animation state is processed by step_animations()
 		auto& timer_registry = registry.timer;
-		for (Entity entity : registry.animations.entities) {
-			if (!registry.timer.has(entity)) {
-				Animation& animation = registry.animations.get(entity);
-				animation.elapsed_ms += elapsed_ms_since_last_update;
-
-				if (animation.elapsed_ms > ANIMATION_SPEED) {
-					animation.current_frame = (animation.current_frame + 1) % animation.num_frames;
-					animation.elapsed_ms = 0.f;
-				}
-			}
-		}
-
 		if (state.used_screen == SCREEN_ID::MAZE && timer_registry.components.size()>1) {
 			Animation& animation1 = registry.animations.get(timer1);
 			Animation& animation2 = registry.animations.get(timer2);
@@ -279,6 +318,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 				registry.renderRequests.remove(entity);
 				// As card has motion, move it outside of screen
 				registry.motions.get(entity).position = { 0.f - CARD_BB_WIDTH, 0.f - CARD_BB_HEIGHT };
+				update_navigation(entity);
 			}
 		}
 	}
@@ -288,6 +328,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			// If player's turn is over, switch over to the opponent
 			battle.is_my_turn = false;
 			battle.current_mode = MODE_ID::SELECT;
+			assert(current_boss.is_alive());
 			registry.battles.get(current_boss).is_my_turn = true;
 
 			// If opponent's health has dropped to 0...
@@ -391,6 +432,26 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	return true;
 }
 
+// Update the frames of the animated sprites
+void WorldSystem::step_animations(float elapsed_ms) {
+	PROFILE_SCOPE("WorldSystem::step_animations");
+	assert(registry.screenStates.components.size() <= 1);
+	const ScreenState& state = registry.screenStates.components[0];
+	if (state.used_state != STATE_ID::IDLE)
+		return;
+
+	// Timers are animated by `WorldSystem::step`
+	registry.view<Animation>(exclude<Timer>)
+		.each([&](Entity, Animation& animation) {
+			animation.elapsed_ms += elapsed_ms;
+
+			if (animation.elapsed_ms > ANIMATION_SPEED) {
+				animation.current_frame = (animation.current_frame + 1) % animation.num_frames;
+				animation.elapsed_ms = 0.f;
+			}
+		});
+}
+
 // Reset the world state to its initial state
 void WorldSystem::restart_game() {
 	// Debugging for memory/component leaks
@@ -403,6 +464,8 @@ void WorldSystem::restart_game() {
 	// Remove all entities that we created
 	while (registry.motions.entities.size() > 0)
 		registry.remove_all_components_of(registry.motions.entities.back());
+	while (registry.tileMaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tileMaps.entities.back());
 
 	// Debugging for memory/component leaks
 	registry.list_all_components();
@@ -620,6 +683,7 @@ void WorldSystem::load_game()
 
 // Generate main menu
 void WorldSystem::generate_menu() {
+	PROFILE_SCOPE("WorldSystem::generate_menu");
 	createMenu(renderer, { window_width_px / 2.f, window_height_px / 2.f });
 
 	std::ifstream file(save_path("save.txt"));
@@ -636,20 +700,24 @@ void WorldSystem::generate_menu() {
 
 // Generate instructions
 void WorldSystem::generate_instructions() {
+	PROFILE_SCOPE("WorldSystem::generate_instructions");
 	createInstructions(renderer, { window_width_px / 2.f, window_height_px / 2.f  });
 	createInstructionsClose(renderer, { window_width_px - 50, 50 });
 }
 void WorldSystem::generate_story() {
+	PROFILE_SCOPE("WorldSystem::generate_story");
 	createStory(renderer, { window_width_px / 2.f, window_height_px / 2.f  });
 	createClose(renderer, { window_width_px - 50, 50 });
 }
 
 void WorldSystem::generate_game_over() {
+	PROFILE_SCOPE("WorldSystem::generate_game_over");
 	createGameOver(renderer, { window_width_px / 2.f, window_height_px / 2.f });
 }
 
 // Clear the world and generate hub to access other biomes
 void WorldSystem::generate_hub() {
+	PROFILE_SCOPE("WorldSystem::generate_hub");
 	// Remove all entities that we created (applies when coming from another biome)
 	auto& player_registry = registry.players;
 	auto& motion_registry = registry.motions;
@@ -662,20 +730,13 @@ void WorldSystem::generate_hub() {
 			registry.renderRequests.remove(motion_registry.entities[i]);
 	}
 
+	// The tile map has no motion, it is removed on its own
+	while (registry.tileMaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tileMaps.entities.back());
+
 	// Create tiles
 	Player& player = player_registry.get(player_character);
-	for (int col = 0; col < NUM_TILES_ACROSS; col++) {
-		for (int row = 0; row < NUM_TILES_DOWN; row++) {
-			vec2 position = {
-				col * TILE_BB_WIDTH + (TILE_BB_WIDTH / 2),
-				row * TILE_BB_HEIGHT + (TILE_BB_HEIGHT / 2) };
-
-			if (hub[row * NUM_TILES_ACROSS + col] == (int)TILES::WALL)
-				createWall(renderer, position, player.current_biome);
-			else
-				createPath(renderer, position, player.current_biome);
-		}
-	}
+	createTileMap(hub, player.current_biome);
 
 	// Create non-interactable objects
 	std::uniform_int_distribution<int>
@@ -719,17 +780,21 @@ void WorldSystem::generate_hub() {
 	// Create NPC
 	createNpc(renderer, { window_width_px / 2, window_height_px / 3 });
 
-	// Re-draw character last
+	// Re-draw character
 	registry.motions.get(player_character).position = { window_width_px / 2, window_height_px / 2 };
 	registry.renderRequests.insert(
 		player_character,
 		{ TEXTURE_ASSET_ID::CHARACTER_DOWN,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PLAYER });
+
+	build_navigation();
 }
 
 // Clear the world and procedurally generate map
 void WorldSystem::generate_random_map() {
+	PROFILE_SCOPE("WorldSystem::generate_random_map");
 	// Remove all entities that we created
 	auto& player_registry = registry.players;
 	auto& motion_registry = registry.motions;
@@ -742,24 +807,17 @@ void WorldSystem::generate_random_map() {
 			registry.renderRequests.remove(motion_registry.entities[i]);
 	}
 
+	// The tile map has no motion, it is removed on its own
+	while (registry.tileMaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tileMaps.entities.back());
+
 	// Create map (WorldSystem::walk_path adds paths)
 	std::fill(map.begin(), map.end(), (int)TILES::WALL);
 	walk_path();
 
 	// Create tiles
 	Player& player = player_registry.get(player_character);
-	for (int col = 0; col < NUM_TILES_ACROSS; col++) {
-		for (int row = 0; row < NUM_TILES_DOWN; row++) {
-			vec2 position = {
-				col * TILE_BB_WIDTH + (TILE_BB_WIDTH / 2),
-				row * TILE_BB_HEIGHT + (TILE_BB_HEIGHT / 2) };
-
-			if (map[row * NUM_TILES_ACROSS + col] == (int)TILES::WALL)
-				createWall(renderer, position, player.current_biome);
-			else
-				createPath(renderer, position, player.current_biome);
-		}
-	}
+	createTileMap(map, player.current_biome);
 
 	// Create chests
 	for (uint i = 0; i < MAX_CHESTS; i++) {
@@ -781,7 +839,10 @@ void WorldSystem::generate_random_map() {
 		player_character,
 		{ TEXTURE_ASSET_ID::CHARACTER_DOWN,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PLAYER });
+
+	build_navigation();
 }
 
 // Spawn random walker to procedurally generate map
@@ -812,6 +873,7 @@ void WorldSystem::walk_path() {
 
 // Clear the world and procedurally generate maze
 void WorldSystem::generate_random_maze() {
+	PROFILE_SCOPE("WorldSystem::generate_random_maze");
 	// Remove all entities that we created
 	auto& player_registry = registry.players;
 	auto& motion_registry = registry.motions;
@@ -824,6 +886,10 @@ void WorldSystem::generate_random_maze() {
 			registry.renderRequests.remove(motion_registry.entities[i]);
 	}
 
+	// The tile map has no motion, it is removed on its own
+	while (registry.tileMaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tileMaps.entities.back());
+
 	MAZE_TIMER_CURRENT = 0;
 
 	// Create maze (WorldSystem::divide_maze adds walls)
@@ -832,18 +898,7 @@ void WorldSystem::generate_random_maze() {
 
 	// Create tiles
 	Player& player = player_registry.get(player_character);
-	for (int col = 0; col < NUM_TILES_ACROSS; col++) {
-		for (int row = 0; row < NUM_TILES_DOWN; row++) {
-			vec2 position = {
-				col * TILE_BB_WIDTH + (TILE_BB_WIDTH / 2),
-				row * TILE_BB_HEIGHT + (TILE_BB_HEIGHT / 2) };
-
-			if (maze[row * NUM_TILES_ACROSS + col] == (int)TILES::WALL)
-				createWall(renderer, position, player.current_biome);
-			else
-				createPath(renderer, position, player.current_biome);
-		}
-	}
+	createTileMap(maze, player.current_biome);
 
 	// Create interactables
 	for (uint i = 0; i < MAX_ITEMS; i++) {
@@ -878,12 +933,15 @@ void WorldSystem::generate_random_maze() {
 		player_character,
 		{ TEXTURE_ASSET_ID::CHARACTER_DOWN,
 		  EFFECT_ASSET_ID::TEXTURED,
-		  GEOMETRY_BUFFER_ID::SPRITE });
+		  GEOMETRY_BUFFER_ID::SPRITE,
+		  RENDER_LAYER::PLAYER });
 
 	// Create timer
 	timer1 = createTimer(renderer, { 860, 50 }, 9, 10000.f);
 	timer2 = createTimer(renderer, { 910, 50 }, 0, 1000.f);
 	registry.animations.get(timer1).elapsed_ms = 9000.f;
+
+	build_navigation();
 }
 
 // Recursively carve out maze
@@ -981,6 +1039,7 @@ vec2 WorldSystem::choose_position(std::vector<int>& tiles) {
 
 // Clear the world and generate board for card battle
 void WorldSystem::generate_board() {
+	PROFILE_SCOPE("WorldSystem::generate_board");
 	// Remove all entities that we created
 	auto& motion_registry = registry.motions;
 	for (int i = (int)motion_registry.components.size() - 1; i >= 0; --i) {
@@ -993,6 +1052,10 @@ void WorldSystem::generate_board() {
 			registry.renderRequests.remove(motion_registry.entities[i]);
 	}
 
+	// The tile map has no motion, it is removed on its own
+	while (registry.tileMaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tileMaps.entities.back());
+
 	// Create health bars
 	Entity bar = createBarUI({ window_width_px / 2, BOARD_OPPONENT_HEALTH_HEIGHT }, 
 		{ window_width_px, BOARD_HEALTH_BB_HEIGHT });
@@ -1012,7 +1075,7 @@ void WorldSystem::generate_board() {
 	// Render cards currently in deck
 	int cards_in_hand = 0;
 	auto& deck_registry = registry.playerDecks;
-	while (deck_registry.components.size() > 0) {
+	while (deck_registry.size() > 0) {
 		Motion& motion = motion_registry.get(get_card_player_deck());
 		motion.position = { (cards_in_hand + 0.5) * window_width_px / MAX_PLAY, CARD_PLAYER_HAND_HEIGHT };
 
@@ -1031,6 +1094,7 @@ void WorldSystem::generate_board() {
 
 // Compute collisions between entities
 void WorldSystem::handle_collisions(float elapsed_ms) {
+	PROFILE_SCOPE("WorldSystem::handle_collisions");
 	// Elapsed time in seconds
 	float step_seconds = elapsed_ms / 1000.f;
 
@@ -1054,7 +1118,7 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 				if (!registry.screenTimers.has(entity)) {
 					// Teleport, reset timer, and make next screen a biome or hub
 					registry.screenTimers.emplace(entity);
-					Mix_PlayChannel(-1, character_teleport_sound, 0);
+					play_sound(character_teleport_sound);
 
 					player.current_biome = registry.biomes.get(entity_other).used_biome;
 					if (player.current_biome == BIOME_ID::HUB)
@@ -1074,7 +1138,7 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 				if (!registry.screenTimers.has(entity)) {
 					// Teleport, reset timer, and transition to next screen
 					registry.screenTimers.emplace(entity);
-					Mix_PlayChannel(-1, character_teleport_sound, 0);
+					play_sound(character_teleport_sound);
 
 					if (registry.subBosses.has(entity_other))
 						state.used_screen = SCREEN_ID::MAZE;
@@ -1085,6 +1149,8 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 						registry.battles.get(player_character).is_my_turn = true; // player starts first
 					}
 				}
+				// The enemy stood still or became traversable
+				update_navigation(entity_other);
 			}
 			// Checking Player - Lootable collisions
 			else if (registry.lootables.has(entity_other)) {
@@ -1092,7 +1158,7 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 				if (!lootable.is_looted) {
 					// Chest has been looted
 					lootable.is_looted = true;
-					Mix_PlayChannel(-1, chest_open_sound, 0);
+					play_sound(chest_open_sound);
 
 					TEXTURE_ASSET_ID used_texture;
 					switch (registry.tiers.get(entity_other).used_tier)
@@ -1131,6 +1197,7 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 
 					registry.playerDecks.emplace(card);
 					registry.cardAppearTimers.emplace(card);
+					update_navigation(card);
 					state.used_state = STATE_ID::LOOT;
 				}
 			}
@@ -1143,7 +1210,7 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 			else if (registry.interactables.has(entity_other)) {
 				// Update current health
 				if (registry.healthComponents.has(entity_other)) {
-					Mix_PlayChannel(-1, item_acquire_health_sound, 0);
+					play_sound(item_acquire_health_sound);
 					Health& player_health = registry.healthComponents.get(player_character);
 					Health& item_health = registry.healthComponents.get(entity_other);
 
@@ -1152,13 +1219,14 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 				}
 				// Update current damage output
 				else if (registry.damageComponents.has(entity_other)) {
-					Mix_PlayChannel(-1, item_acquire_damage_sound, 0);
+					play_sound(item_acquire_damage_sound);
 					Damage& player_damage = registry.damageComponents.get(player_character);
 					Damage& item_damage = registry.damageComponents.get(entity_other);
 
 					player_damage.damage_output += item_damage.damage_output;
 				}
 
+				remove_from_navigation(entity_other);
 				registry.remove_all_components_of(entity_other);
 			}
 
@@ -1186,7 +1254,20 @@ void WorldSystem::handle_collisions(float elapsed_ms) {
 
 // Should the game be over?
 bool WorldSystem::is_over() const {
-	return bool(glfwWindowShouldClose(window));
+#ifndef IOLS_HEADLESS
+	if (!is_headless() && glfwWindowShouldClose(window))
+		return true;
+#endif
+	return is_closing;
+}
+
+void WorldSystem::play_sound(Mix_Chunk* sound) {
+#ifndef IOLS_HEADLESS
+	if (!is_headless())
+		Mix_PlayChannel(-1, sound, 0);
+#else
+	(void)sound;
+#endif
 }
 
 // On key callback
@@ -1273,9 +1354,6 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
   
 	// Resetting game
 	if (action == GLFW_RELEASE && key == GLFW_KEY_R) {
-		int w, h;
-		glfwGetWindowSize(window, &w, &h);
-
 		restart_game();
 	}
 
@@ -1287,14 +1365,21 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 			debugging.in_debug_mode = true;
 	}
 
+#ifdef IOLS_PROFILE
+	// Saving the profiler zones so far, they are saved at exit as well
+	// Input is handled between ticks, no other thread records zones now
+	if (action == GLFW_RELEASE && key == GLFW_KEY_P)
+		profiler.write_trace(trace_path("trace.json"));
+#endif
+
 	// Escape game
 	if (action == GLFW_RELEASE && key == GLFW_KEY_ESCAPE)
-		glfwSetWindowShouldClose(window, GLFW_TRUE);
+		is_closing = true;
 }
 
 // On mouse movement callback
-void WorldSystem::on_mouse_move(vec2 mouse_position) {
-	(vec2)mouse_position; // dummy to avoid compiler warning
+void WorldSystem::on_mouse_move(vec2 position) {
+	mouse_position = position;
 }
 
 // On mouse click callback
@@ -1302,11 +1387,6 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 	(int)mod; // dummy to avoid compiler warning
 
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-		// Get the mouse's current position
-		double mouse_x, mouse_y;
-		glfwGetCursorPos(window, &mouse_x, &mouse_y);
-		vec2 mouse_position = vec2(mouse_x, mouse_y);
-		
 		// The screen and its state
 		assert(registry.screenStates.components.size() <= 1);
 		ScreenState& state = registry.screenStates.components[0];
@@ -1367,13 +1447,13 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 			Battle& battle = registry.battles.get(player_character);
 			if (battle.is_my_turn && battle.current_mode == MODE_ID::SELECT) {
 				// Skip if cards at play have reached the maximum
-				if (registry.playerPlays.components.size() < MAX_PLAY) {
+				if (registry.playerPlays.size() < MAX_PLAY) {
 					// Add a new card if generator is selected and holding less than three cards
 					Motion& generator = motion_registry.get(registry.generators.entities.back());
 					if (collides_with_mouse(mouse_position, generator) &&
-						hand_registry.components.size() < MAX_HAND) {
+						hand_registry.size() < MAX_HAND) {
 						// Get a card from the player's deck
-						if (registry.playerDecks.components.size() > 0) {
+						if (registry.playerDecks.size() > 0) {
 							Motion& motion = motion_registry.get(get_card_player_deck());
 							motion.position = choose_placement_player_hand();
 						}
@@ -1390,8 +1470,8 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 					}
 
 					// Determine which card was selected
-					if (hand_registry.components.size() > 0) {
-						for (int i = (int)hand_registry.components.size() - 1; i >= 0; i--) {
+					if (hand_registry.size() > 0) {
+						for (int i = (int)hand_registry.size() - 1; i >= 0; i--) {
 							Entity card = hand_registry.entities[i];
 							Motion& motion = motion_registry.get(card);
 
@@ -1414,15 +1494,17 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 			}
 			else if (battle.is_my_turn && battle.current_mode == MODE_ID::PLACE) {
 				// Skip if cards at play have reached the maximum
-				if (registry.playerPlays.components.size() < MAX_PLAY) {
+				if (registry.playerPlays.size() < MAX_PLAY) {
 					// Determine where card is to be placed
 					auto& board_player_registry = registry.boardPlayers;
-					for (int i = (int)board_player_registry.components.size() - 1; i >= 0; i--) {
+					for (int i = (int)board_player_registry.size() - 1; i >= 0; i--) {
 						Entity card_placement = board_player_registry.entities[i];
 						Motion& motion = motion_registry.get(card_placement);
 
 						// Remove the card from hand, put it in play, and switch to card play mode
-						if (collides_with_mouse(mouse_position, motion) &&
+						// (the selected card may have been destroyed since, a stale handle is skipped)
+						if (selected_card.is_alive() &&
+							collides_with_mouse(mouse_position, motion) &&
 							card_placement_unoccupied(motion.position, registry.playerPlays)) {
 							hand_registry.remove(selected_card);
 							registry.playerPlays.emplace(selected_card);
@@ -1443,26 +1525,26 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 			}
 		}
 		else if (state.used_screen == SCREEN_ID::HUB || state.used_screen == SCREEN_ID::BIOME) {
-			// Check that player clicked on a legal desitination
-			auto& motion_registry = registry.motions;
-			auto& traversable_registry = registry.traversables;
-			for (uint i = 0; i < traversable_registry.components.size(); i++) {
+			// Check that player clicked on a legal desitination, a path tile with nothing on it
+			bool reachable = false;
+			if (registry.tileMaps.size() > 0) {
+				const TileMap& tile_map = registry.tileMaps.components.back();
+				reachable = mouse_position.x >= 0 && mouse_position.x < tile_map.columns * tile_map.tile_size.x &&
+					mouse_position.y >= 0 && mouse_position.y < tile_map.rows * tile_map.tile_size.y &&
+					!tile_map.is_wall_at(mouse_position) && !obstacle_on_traversable(mouse_position);
+			}
+			if (reachable) {
 				// Calculate a path for the player's character to follow
-				Motion& motion_i = motion_registry.get(traversable_registry.entities[i]);
-				if (collides_with_mouse(mouse_position, motion_i) && !obstacle_on_traversable(mouse_position)) {
-					Motion& player_motion = motion_registry.get(player_character);
-					player_motion.path = path_find(player_motion.position, mouse_position, player_motion);
-					if (player_motion.path == NULL)
-						std::cout << "No path found" << std::endl;
-					else {
-						player_motion.is_enroute = true;
-						std::cout << "Path found" << std::endl;
-					}
-					break;
+				Motion& player_motion = registry.motions.get(player_character);
+				if (!path_find(player_motion.position, mouse_position, player_motion, player_motion.path))
+					std::cout << "No path found" << std::endl;
+				else {
+					player_motion.is_enroute = true;
+					std::cout << "Path found" << std::endl;
 				}
-				else
-					std::cout << "Destination is not reachable" << std::endl;
 			}
+			else
+				std::cout << "Destination is not reachable" << std::endl;
 		}
 	}
 }
@@ -1488,21 +1570,99 @@ bool WorldSystem::collides_with_mouse(const vec2 mouse_position, const Motion& o
 // Determine whether another entity is rendered on top of a traversable
 bool WorldSystem::obstacle_on_traversable(vec2 mouse_position) {
 	bool occupied = false;
-	auto& motion_registry = registry.motions;
-	for (uint i = 0; i < motion_registry.components.size(); i++) {
-		// Skip entities that are traversable
-		Entity entity_i = motion_registry.entities[i];
-		if (registry.traversables.has(entity_i))
-			continue;
+	registry.view<Motion>(exclude<Traversable>)
+		.each([&](Entity, Motion& motion) {
+			occupied = occupied || collides_with_mouse(mouse_position, motion);
+		});
 
-		Motion& motion_i = motion_registry.components[i];
-		if (collides_with_mouse(mouse_position, motion_i)) {
-			occupied = true;
-			break;
+	return occupied;
+}
+
+// Occupancy of the static bodies that are neither traversable nor the player's character
+void WorldSystem::build_navigation() {
+	const vec2 bounding_box = abs(registry.motions.get(player_character).scale) / 2.f;
+	navigation_radius = sqrt(dot(bounding_box, bounding_box));
+	navigation.assign(NAVIGATION_COLUMNS * NAVIGATION_ROWS, 0);
+
+	// Every static body remembers the shape it was counted with
+	registry.navigationObstacles.clear();
+	std::vector<NavigationObstacle> obstacles;
+	registry.view<Motion>(exclude<Traversable, Player>)
+		.each([&](Entity entity, Motion& motion) {
+			if (motion.velocity == vec2(0, 0))
+				obstacles.push_back(registry.navigationObstacles.insert(entity, { motion.position, motion.scale }));
+		});
+
+	// Walls are only in the tile map
+	for (const TileMap& tile_map : registry.tileMaps.components) {
+		NavigationObstacle wall;
+		wall.scale = tile_map.tile_size;
+		for (int row = 0; row < tile_map.rows; row++) {
+			for (int column = 0; column < tile_map.columns; column++) {
+				if (!tile_map.is_wall(column, row))
+					continue;
+				wall.position = tile_map.tile_center(column, row);
+				obstacles.push_back(wall);
+			}
 		}
 	}
 
-	return occupied;
+	// Bands of rows are filled in as jobs, each job only writes the cells of its band
+	job_system.parallel_for(0, NAVIGATION_ROWS, NAVIGATION_ROWS_PER_JOB, [&](size_t first_row, size_t last_row) {
+		for (const NavigationObstacle& obstacle : obstacles)
+			update_navigation(obstacle, 1, (int)first_row, (int)last_row);
+	});
+}
+
+// Counts the entity in the grid if it is a static body, after taking out what it was counted as
+void WorldSystem::update_navigation(Entity entity) {
+	remove_from_navigation(entity);
+	const Motion* motion = registry.motions.find(entity);
+	if (navigation.empty() || !motion || motion->velocity != vec2(0, 0) || !registry.has_none<Traversable, Player>(entity))
+		return;
+	update_navigation(registry.navigationObstacles.insert(entity, { motion->position, motion->scale }), 1);
+}
+
+void WorldSystem::remove_from_navigation(Entity entity) {
+	const NavigationObstacle* counted = registry.navigationObstacles.find(entity);
+	if (!counted)
+		return;
+	update_navigation(*counted, -1);
+	registry.navigationObstacles.remove(entity);
+}
+
+// Add (delta 1) or remove (delta -1) a static body from the occupancy grid
+// A cell is occupied if PhysicsSystem::collides would report the character at its centre
+// colliding with the body, i.e. the distance is below the larger of both radii
+// Only the rows from first_row up to last_row, exclusive, are updated
+void WorldSystem::update_navigation(const NavigationObstacle& obstacle, int delta, int first_row, int last_row) {
+	if (navigation.empty())
+		return;
+	const vec2 bounding_box = abs(obstacle.scale) / 2.f;
+	const float radius = max(sqrt(dot(bounding_box, bounding_box)), navigation_radius);
+
+	const int min_column = max((int)floor((obstacle.position.x - radius) / GRANULARITY), 0);
+	const int max_column = min((int)floor((obstacle.position.x + radius) / GRANULARITY), NAVIGATION_COLUMNS - 1);
+	const int min_row = max((int)floor((obstacle.position.y - radius) / GRANULARITY), first_row);
+	const int max_row = min((int)floor((obstacle.position.y + radius) / GRANULARITY), min(last_row, NAVIGATION_ROWS) - 1);
+	for (int row = min_row; row <= max_row; row++) {
+		for (int column = min_column; column <= max_column; column++) {
+			const vec2 dp = vec2((column + 0.5f) * GRANULARITY, (row + 0.5f) * GRANULARITY) - obstacle.position;
+			if (dot(dp, dp) >= radius * radius)
+				continue;
+			unsigned short& count = navigation[row * NAVIGATION_COLUMNS + column];
+			assert((delta > 0 || count > 0) && "Removed a body that was not counted in the navigation grid");
+			count = (unsigned short)(count + delta);
+		}
+	}
+}
+
+bool WorldSystem::navigation_blocked(vec2 position) const {
+	const int column = (int)floor(position.x / GRANULARITY);
+	const int row = (int)floor(position.y / GRANULARITY);
+	if (column < 0 || column >= NAVIGATION_COLUMNS || row < 0 || row >= NAVIGATION_ROWS)
+		return false;
+	return navigation[row * NAVIGATION_COLUMNS + column] != 0;
 }
 
 // Use Manhatten heuristic as player can only move in 4 directions
@@ -1510,115 +1670,96 @@ double WorldSystem::calc_heuristic(vec2 a, vec2 b) {
 	return std::abs(a.x - b.x) + std::abs(a.y - b.y);
 }
 
-// Determines path player's character should follow; returns NULL if no path found
-Path* WorldSystem::path_find(vec2 start, vec2 dest, Motion& motion_p) {
-	Path* path = new Path();
-	path->next = start;
+// Determines path player's character should follow; returns false if no path found
+// A* over a lattice with GRANULARITY spacing that starts at the player's position and is bounded
+// by the window. The open list is a binary heap and each lattice cell has its cost, parent and
+// closed flag in flat arrays, so no node is allocated and duplicates are resolved by cell.
+bool WorldSystem::path_find(vec2 start, vec2 dest, const Motion& motion_p, Path& path) {
+	PROFILE_SCOPE("WorldSystem::path_find");
+	path.next = start;
+	path.path_stack.clear();
+
+	// The lattice starts at the character, which has to be within the window
+	if (start.x < 0 || start.x > window_width_px || start.y < 0 || start.y > window_height_px)
+		return false;
+
+	// Lattice cells within the window
+	const int min_x = -(int)floor(start.x / GRANULARITY);
+	const int min_y = -(int)floor(start.y / GRANULARITY);
+	const int columns = (int)floor((window_width_px - start.x) / GRANULARITY) - min_x + 1;
+	const int rows = (int)floor((window_height_px - start.y) / GRANULARITY) - min_y + 1;
+	if (columns <= 0 || rows <= 0)
+		return false;
+	auto position_of = [&](int cell) {
+		return vec2(start.x + (cell % columns + min_x) * GRANULARITY, start.y + (cell / columns + min_y) * GRANULARITY);
+	};
 
-	struct Node {
-		vec2 pos;
-		int cost; // distance to get to this node, following path laid out via parents
-		int heuristic; // Euclidean distance from this node to the destination
-		Node* parent;
+	path_open.clear();
+	path_cost.assign(columns * rows, -1);
+	path_parent.assign(columns * rows, -1);
+	path_closed.assign(columns * rows, 0);
 
-		bool operator == (const Node& a) {
-			return (pos.x == a.pos.x && pos.y == a.pos.y);
-		}
-	};
+	// The occupancy grid is built for the size of the player's character
+	const vec2 bounding_box = abs(motion_p.scale) / 2.f;
+	if (sqrt(dot(bounding_box, bounding_box)) != navigation_radius)
+		build_navigation();
 
-	std::vector<Node*> open_list;
-	std::vector<Node*> closed_list;
+	// Lowest f at the top of the heap, ties go to the node closer to the destination
+	auto greater = [](const PathNode& a, const PathNode& b) {
+		return a.f > b.f || (a.f == b.f && a.heuristic > b.heuristic);
+	};
 
-	Node* start_node = new Node({ start, 0, 0, NULL });
-	open_list.push_back(start_node);
+	const int start_cell = -min_y * columns - min_x;
+	const float start_heuristic = (float)calc_heuristic(start, dest);
+	path_cost[start_cell] = 0;
+	path_open.push_back({ start_heuristic, start_heuristic, start_cell });
 
-	// `open_list` will have decsending order where the lowest `f` is at the back of the list 
-	while (!open_list.empty()) {
-		// Access current node that has the smallest f (an estimate of the
-		// cost of a path from the start to a goal via q) on the list
-		Node* current = open_list.back();
+	while (!path_open.empty()) {
+		// Take the node with the smallest f (an estimate of the cost of a path from the start
+		// to the destination via this node) off of the open list
+		std::pop_heap(path_open.begin(), path_open.end(), greater);
+		const int current = path_open.back().cell;
+		path_open.pop_back();
 
-		// Pop current node off of the open list
-		open_list.pop_back();
+		// Stale entry, the cell was reached on a cheaper path since
+		if (path_closed[current])
+			continue;
+		path_closed[current] = 1;
 
 		// Check if current node is the destination
-		if (calc_heuristic(current->pos, dest) <= GRANULARITY * 2) {
-			path->path_stack.push(current->pos);
-			while (current->parent != NULL) {
-				current = current->parent;
-				path->path_stack.push(current->pos);
-			}
-			return path;
+		const vec2 current_position = position_of(current);
+		if (calc_heuristic(current_position, dest) <= GRANULARITY * 2) {
+			for (int cell = current; cell != -1; cell = path_parent[cell])
+				path.path_stack.push_back(position_of(cell));
+			return true;
 		}
-		printf("(x,y) = (%f, %f)\n", current->pos.x, current->pos.y);
-		
-		// Set neighbours
-		std::vector<Node*> neighbours = {
-			new Node({{ current->pos.x - GRANULARITY,current->pos.y }, GRANULARITY, 0, current}),
-			new Node({{ current->pos.x + GRANULARITY,current->pos.y }, GRANULARITY, 0, current}),
-			new Node({{ current->pos.x, current->pos.y - GRANULARITY }, GRANULARITY, 0, current}),
-			new Node({{ current->pos.x, current->pos.y + GRANULARITY }, GRANULARITY, 0, current})
-		};
-
-		for (Node* nextp : neighbours) {
-			Node& next = *nextp;
-
-			// Check if neighbour is an obstacle; if true, put it in on the closed list and skip
-			int next_is_obstacle = false;
-			ComponentContainer<Motion> &motion_container = registry.motions;
-			for (uint i = 0; i < motion_container.components.size(); i++)
-			{
-				Entity entity_i = motion_container.entities[i];
-				// Skip entities that are traversable and the player character
-				if (registry.traversables.has(entity_i) || registry.players.has(entity_i))
-					continue;
-
-				// Skip mobile entities
-				Motion& motion_i = motion_container.components[i];
-				if (motion_i.velocity != vec2(0,0))
-					continue;
 
-				if (PhysicsSystem::collides(motion_i, 
-					Motion{ next.pos, motion_p.angle, { 0, 0 }, motion_p.scale})) {
-					std::cout << "Collision detected" << std::endl;
-					next_is_obstacle = true;
-					break;
-				}
-			}
-			if (next_is_obstacle)
-			{
-				next.heuristic = 0; // ensures that node will be percived as already searched
-				closed_list.push_back(nextp);
+		// Expand the four neighbours
+		const int x = current % columns;
+		const int y = current / columns;
+		const int neighbours[4][2] = { { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+		for (const auto& neighbour : neighbours) {
+			if (neighbour[0] < 0 || neighbour[0] >= columns || neighbour[1] < 0 || neighbour[1] >= rows)
 				continue;
-			}
-
-			next.cost = current->cost + next.cost;
-			next.heuristic = calc_heuristic(next.pos, dest);
-
-			auto check_list_for_same_and_less_f = [](Node next, std::vector<Node*> list) {
-				for (Node* n : list) {
-					if (next == *n && (n->cost + n->heuristic) <= (next.cost + next.heuristic))
-						return true;
-				}
-				return false;
-			};
-
-			if (check_list_for_same_and_less_f(next, open_list) ||
-				check_list_for_same_and_less_f(next, closed_list))
+			const int next = neighbour[1] * columns + neighbour[0];
+			const int cost = path_cost[current] + 1;
+			if (path_closed[next] || (path_cost[next] != -1 && path_cost[next] <= cost))
 				continue;
 
-			open_list.push_back(nextp);
+			const vec2 next_position = position_of(next);
+			if (navigation_blocked(next_position)) {
+				path_closed[next] = 1;
+				continue;
+			}
 
-			// Computationally cheaper to sort an already sorted list
-			auto sort_list = [](std::vector<Node*>* list) {
-				std::stable_sort(list->begin(), list->end(), 
-					[](Node* n1, Node* n2) { return n1->cost + n1->heuristic > n2->cost + n2->heuristic; });
-			};
-			sort_list(&open_list);
+			path_cost[next] = cost;
+			path_parent[next] = current;
+			const float heuristic = (float)calc_heuristic(next_position, dest);
+			path_open.push_back({ cost * GRANULARITY + heuristic, heuristic, next });
+			std::push_heap(path_open.begin(), path_open.end(), greater);
 		}
-		closed_list.push_back(current);
 	}
-	
+
 	// No path found
-	return NULL;
+	return false;
 }
\ No newline at end of file
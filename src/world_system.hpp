@@ -4,6 +4,7 @@
 #include "common.hpp"
 
 // stlib
+#include <climits>
 #include <vector>
 #include <random>
 
@@ -12,6 +13,8 @@
 #include <SDL_mixer.h>
 
 #include "render_system.hpp"
+#include "task_scheduler.hpp"
+#include "tiny_ecs_registry.hpp"
 #include "world_init.hpp"
 
 // Container for all our entities and game logic. Individual rendering / update is
@@ -25,16 +28,29 @@ public:
 	GLFWwindow* create_window();
 
 	// starts the game
-	void init(RenderSystem* renderer);
+	// Without create_window() the game runs headless: no window and no audio, input comes from
+	// the input callbacks being called directly, see InputScript
+	void init(RenderSystem* renderer, const TaskScheduler* scheduler);
+	bool is_headless() const { return window == nullptr; }
 
 	// Releases all associated resources
 	~WorldSystem();
 
 	// Steps the game ahead by ms milliseconds
+	// The steps run as tasks of the TaskScheduler, with the registry access declared here
+	// step() generates the screens and sets the window title, so it is structural
 	bool step(float elapsed_ms);
+	static constexpr TaskAccess STEP_ACCESS = STRUCTURAL_ACCESS;
+
+	// Steps the sprite animations ahead, apart from the maze timer
+	void step_animations(float elapsed_ms);
+	static constexpr TaskAccess STEP_ANIMATIONS_ACCESS = {
+		GameRegistry::mask<ScreenState, Timer>(), GameRegistry::mask<Animation>() };
 
 	// Check for collisions
+	// Structural, it removes picked up items, creates loot cards and plays sounds
 	void handle_collisions(float elapsed_ms);
+	static constexpr TaskAccess HANDLE_COLLISIONS_ACCESS = STRUCTURAL_ACCESS;
 
 	// Should the game be over?
 	bool is_over()const;
@@ -71,12 +87,14 @@ public:
 	// Path calculator
 	static const int GRANULARITY; // size of nodes the map is divided into
 	static double calc_heuristic(vec2 a, vec2 b);
-	struct Path* path_find(vec2 start, vec2 dest, Motion& motion_p);
-private:
-	// Input callback functions
+	bool path_find(vec2 start, vec2 dest, const Motion& motion_p, Path& path);
+
+	// Input callback functions, called by the window or by the script of a headless run
+	// Keys and buttons are GLFW codes, the mouse position is in window coordinates
 	void on_key(int key, int, int action, int mod);
 	void on_mouse_move(vec2 pos);
 	void on_mouse_button(int button, int action, int mod);
+private:
 
 	// Determine if entity was clicked on
 	bool collides_with_mouse(const vec2 mouse_position, const Motion& other);
@@ -115,11 +133,14 @@ private:
 	// Board generator for card battle
 	void generate_board();
 
-	// OpenGL window handle
-	GLFWwindow* window;
+	// OpenGL window handle, nullptr when headless
+	GLFWwindow* window = nullptr;
+	bool is_closing = false; // set by escape, the window has its own close flag as well
+	vec2 mouse_position = { 0.f, 0.f }; // last position given to on_mouse_move
 
 	// Game state
 	RenderSystem* renderer;
+	const TaskScheduler* scheduler; // for the debug title
 	float current_speed;
 	CHARACTER_DIRECTION previous_direction;
 	CHARACTER_DIRECTION current_direction;
@@ -138,12 +159,44 @@ private:
 	Entity timer1;
 	Entity timer2;
 
-	// Music references
-	Mix_Music* background_music;
-	Mix_Chunk* character_teleport_sound;
-	Mix_Chunk* chest_open_sound;
-	Mix_Chunk* item_acquire_health_sound;
-	Mix_Chunk* item_acquire_damage_sound;
+	// Music references, nullptr when headless
+	Mix_Music* background_music = nullptr;
+	Mix_Chunk* character_teleport_sound = nullptr;
+	Mix_Chunk* chest_open_sound = nullptr;
+	Mix_Chunk* item_acquire_health_sound = nullptr;
+	Mix_Chunk* item_acquire_damage_sound = nullptr;
+	void play_sound(Mix_Chunk* sound);
+
+	// Search state of path_find, kept between queries so a search does not allocate
+	// The nodes are the cells of a lattice with GRANULARITY spacing around the start position
+	struct PathNode {
+		float f; // cost so far plus heuristic
+		float heuristic;
+		int cell;
+	};
+	std::vector<PathNode> path_open; // binary heap on f
+	std::vector<int> path_cost; // steps from the start per cell, -1 if not reached yet
+	std::vector<int> path_parent;
+	std::vector<char> path_closed; // 1 once expanded or known to be an obstacle
+
+	// Navigation occupancy grid at GRANULARITY resolution over the window. Each cell counts the
+	// static bodies the player's character would collide with when standing at its centre.
+	// The path_find() lattice starts at the character, not at the cells, so a lattice point is
+	// judged by the centre of its cell, up to half a cell away; coarser than a collision test at
+	// the point itself.
+	// It is rebuilt when a world is generated. Static bodies that are created, stop, start moving
+	// or become traversable afterwards are brought up to date with update_navigation(entity), and
+	// remove_from_navigation(entity) takes one out before it is removed from the registry.
+	static const int NAVIGATION_COLUMNS;
+	static const int NAVIGATION_ROWS;
+	std::vector<unsigned short> navigation;
+	float navigation_radius = -1.f; // radius of the character the grid was built for
+	void build_navigation();
+	static const int NAVIGATION_ROWS_PER_JOB; // build_navigation() fills bands of rows as jobs
+	void update_navigation(const NavigationObstacle& obstacle, int delta, int first_row = 0, int last_row = INT_MAX);
+	void update_navigation(Entity entity);
+	void remove_from_navigation(Entity entity);
+	bool navigation_blocked(vec2 position) const;
 
 	// C++ random number generator
 	std::default_random_engine rng;
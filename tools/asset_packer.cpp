@@ -0,0 +1,131 @@
+// Bakes the textures, shaders and audio of the game into data/assets.pack, see asset_pack.hpp
+// Usage: iols_asset_packer [output path]
+
+// internal
+#include "../src/asset_pack.hpp"
+#include "../ext/project_path.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../ext/stb_image/stb_image.h"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Larger images stay loose files, e.g. the full size maps, they would make the pack huge
+const uint64_t MAX_TEXTURE_BYTES = 32 << 20;
+
+struct PackedFile
+{
+	AssetPackEntry entry;
+	std::vector<uint8_t> contents;
+};
+
+// Adds all files in a directory of the project that end with the extension
+static bool pack_directory(const std::string& directory, const std::string& extension, ASSET_KIND kind, std::vector<PackedFile>& files)
+{
+	std::vector<fs::path> paths;
+	for (const fs::directory_entry& file : fs::directory_iterator(std::string(PROJECT_SOURCE_DIR) + directory))
+	{
+		const std::string name = file.path().filename().string();
+		if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+			paths.push_back(file.path());
+	}
+	std::sort(paths.begin(), paths.end());
+
+	for (const fs::path& path : paths)
+	{
+		PackedFile packed = {};
+		const std::string full_path = path.string();
+		const std::string name = AssetPack::entry_name(full_path);
+		if (name.size() >= sizeof(packed.entry.name))
+		{
+			fprintf(stderr, "Skipping %s, the name is too long\n", name.c_str());
+			continue;
+		}
+		strcpy(packed.entry.name, name.c_str());
+		packed.entry.kind = kind;
+		AssetPack::source_info(full_path, packed.entry.source_time, packed.entry.source_size);
+
+		if (kind == ASSET_KIND::TEXTURE)
+		{
+			// Decoded like RenderSystem::initializeGlTextures does, so it can upload the pixels as they are
+			int width, height;
+			stbi_uc* pixels = stbi_load(full_path.c_str(), &width, &height, NULL, 4);
+			if (pixels == NULL)
+			{
+				fprintf(stderr, "Could not load the file %s\n", full_path.c_str());
+				return false;
+			}
+			const uint64_t bytes = (uint64_t)width * height * 4;
+			if (bytes > MAX_TEXTURE_BYTES)
+			{
+				printf("Leaving out %s, %d x %d is too large\n", name.c_str(), width, height);
+				stbi_image_free(pixels);
+				continue;
+			}
+			packed.entry.width = width;
+			packed.entry.height = height;
+			packed.contents.assign(pixels, pixels + bytes);
+			stbi_image_free(pixels);
+		}
+		else
+		{
+			std::ifstream is(full_path, std::ios::binary);
+			packed.contents.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+		}
+		packed.entry.size = packed.contents.size();
+		files.push_back(std::move(packed));
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string output = argc > 1 ? argv[1] : std::string(PROJECT_SOURCE_DIR) + "data/assets.pack";
+
+	std::vector<PackedFile> files;
+	if (!pack_directory("data/textures", ".png", ASSET_KIND::TEXTURE, files) ||
+		!pack_directory("shaders", ".glsl", ASSET_KIND::SHADER, files) ||
+		!pack_directory("data/audio", ".wav", ASSET_KIND::AUDIO, files))
+		return EXIT_FAILURE;
+
+	// Lay out the data after the table of contents
+	uint64_t offset = sizeof(AssetPackHeader) + files.size() * sizeof(AssetPackEntry);
+	for (PackedFile& file : files)
+	{
+		offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+		file.entry.offset = offset;
+		offset += file.entry.size;
+	}
+
+	std::ofstream os(output, std::ios::binary | std::ios::trunc);
+	AssetPackHeader header = {};
+	memcpy(header.magic, "IOLS", 4);
+	header.version = ASSET_PACK_VERSION;
+	header.entry_count = (uint32_t)files.size();
+	os.write((const char*)&header, sizeof(header));
+	for (const PackedFile& file : files)
+		os.write((const char*)&file.entry, sizeof(file.entry));
+	for (const PackedFile& file : files)
+	{
+		while ((uint64_t)os.tellp() < file.entry.offset)
+			os.put(0);
+		os.write((const char*)file.contents.data(), file.contents.size());
+	}
+	if (!os.good())
+	{
+		fprintf(stderr, "Failed to write %s\n", output.c_str());
+		return EXIT_FAILURE;
+	}
+
+	printf("Packed %d files into %s, %.1f MB\n", (int)files.size(), output.c_str(), offset / (1024.f * 1024.f));
+	return EXIT_SUCCESS;
+}
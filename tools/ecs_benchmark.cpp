@@ -0,0 +1,130 @@
+// Measures the lookup throughput of ComponentContainer::has() and get(), backed by the sparse set
+// index, against the unordered_map from entity id to dense slot it replaced, see tiny_ecs.hpp
+// Usage: iols_ecs_benchmark [entity count]
+
+// internal
+#include "../src/tiny_ecs.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+const int REPETITIONS = 5; // the best of these is reported
+const size_t LOOKUPS = 1 << 22;
+
+// About the size of Motion
+struct Component
+{
+	float position[2];
+	float velocity[2];
+	float scale[2];
+	float angle;
+};
+
+// The lookup of ComponentContainer before the sparse set index
+struct BaselineContainer
+{
+	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	std::vector<Component> components;
+	std::vector<Entity> entities;
+
+	void insert(Entity e, Component c)
+	{
+		map_entity_componentID[e] = (unsigned int)components.size();
+		components.push_back(std::move(c));
+		entities.push_back(e);
+	}
+
+	Component& get(Entity e)
+	{
+		return components[map_entity_componentID[e]];
+	}
+
+	bool has(Entity entity)
+	{
+		return map_entity_componentID.count(entity) > 0;
+	}
+};
+
+// Runs measure() REPETITIONS times and returns the fastest, in nanoseconds
+template <typename F>
+static double best_of(F measure)
+{
+	double best = 0;
+	for (int r = 0; r < REPETITIONS; r++)
+	{
+		const auto start = Clock::now();
+		measure();
+		const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		if (r == 0 || ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+// Looks up every entity of the order in turn until LOOKUPS lookups are done
+// Returns the nanoseconds per has() and per get()
+template <typename Container>
+static void measure(Container& container, const std::vector<Entity>& order, double& has_ns, double& get_ns)
+{
+	volatile size_t found = 0;
+	has_ns = best_of([&]() {
+		size_t count = 0;
+		for (size_t i = 0; i < LOOKUPS; i++)
+			count += container.has(order[i % order.size()]);
+		found = count;
+	}) / LOOKUPS;
+
+	volatile float sum = 0;
+	get_ns = best_of([&]() {
+		float total = 0;
+		for (size_t i = 0; i < LOOKUPS; i++)
+			total += container.get(order[i % order.size()]).angle;
+		sum = total;
+	}) / LOOKUPS;
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t entity_count = argc > 1 ? (size_t)std::max(1, atoi(argv[1])) : 10000;
+
+	// Every other entity gets a component, as in a container that not all entities are part of
+	ComponentContainer<Component> sparse_set;
+	BaselineContainer baseline;
+	std::vector<Entity> sequential;
+	for (size_t i = 0; i < 2 * entity_count; i++)
+	{
+		Entity e = Entity::create();
+		if (i % 2 != 0)
+			continue;
+		const Component c = { { 0, 0 }, { 0, 0 }, { 1, 1 }, (float)i };
+		sparse_set.insert(e, c);
+		baseline.insert(e, c);
+		sequential.push_back(e);
+	}
+	std::vector<Entity> random = sequential;
+	std::shuffle(random.begin(), random.end(), std::default_random_engine(427));
+
+	printf("%zu entities, %zu lookups, ns per lookup\n", entity_count, LOOKUPS);
+	printf("order       container      has()   get()\n");
+	const struct { const char* name; const std::vector<Entity>* order; } orders[] = {
+		{ "sequential", &sequential },
+		{ "random", &random },
+	};
+	for (const auto& order : orders)
+	{
+		double has_ns, get_ns;
+		measure(sparse_set, *order.order, has_ns, get_ns);
+		printf("%-10s  sparse set     %6.2f  %6.2f\n", order.name, has_ns, get_ns);
+		measure(baseline, *order.order, has_ns, get_ns);
+		printf("%-10s  unordered_map  %6.2f  %6.2f\n", order.name, has_ns, get_ns);
+	}
+	return 0;
+}
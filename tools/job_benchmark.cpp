@@ -0,0 +1,101 @@
+// Measures the overhead of dispatching jobs to the JobSystem and how parallel_for scales with
+// the number of threads, see job_system.hpp
+// Usage: iols_job_benchmark [max threads]
+
+// internal
+#include "../src/job_system.hpp"
+
+// stlib
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+const int REPETITIONS = 5; // the best of these is reported
+const size_t EMPTY_JOBS = 100000;
+const size_t ROUND_TRIPS = 20000;
+const size_t ITEMS = 1 << 20;
+const size_t ITEMS_PER_JOB = 4096;
+
+static double elapsed_ns(Clock::time_point start)
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Runs measure() REPETITIONS times and returns the fastest, in nanoseconds
+template <typename F>
+static double best_of(F measure)
+{
+	double best = 0;
+	for (int r = 0; r < REPETITIONS; r++)
+	{
+		const double ns = measure();
+		if (r == 0 || ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+// Some work for every item that the compiler cannot drop
+static float work(size_t item)
+{
+	float x = (float)item;
+	for (int i = 0; i < 64; i++)
+		x = std::sqrt(x * 1.0001f + 1.f);
+	return x;
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned int max_threads = argc > 1 ? (unsigned int)std::max(1, atoi(argv[1]))
+		: std::max(1u, std::thread::hardware_concurrency());
+	std::vector<float> results(ITEMS);
+
+	printf("threads  submit ns/job  async ns/round trip  parallel_for ms  speedup\n");
+	double single_thread_ms = 0;
+	for (unsigned int threads = 1; threads <= max_threads; threads++)
+	{
+		JobSystem pool;
+		pool.start(threads - 1);
+
+		// Empty jobs submitted by this thread, which then waits for all of them
+		const double submit_ns = best_of([&]() {
+			std::atomic<size_t> done(0);
+			const auto start = Clock::now();
+			for (size_t j = 0; j < EMPTY_JOBS; j++)
+				pool.submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+			pool.wait_until([&]() { return done.load(std::memory_order_relaxed) == EMPTY_JOBS; });
+			return elapsed_ns(start);
+		}) / EMPTY_JOBS;
+
+		// One job at a time, each waited for before the next
+		const double round_trip_ns = best_of([&]() {
+			size_t sum = 0;
+			const auto start = Clock::now();
+			for (size_t j = 0; j < ROUND_TRIPS; j++)
+				sum += pool.async([j]() { return j; }).get();
+			const double ns = elapsed_ns(start);
+			if (sum != ROUND_TRIPS * (ROUND_TRIPS - 1) / 2)
+				fprintf(stderr, "async returned wrong results\n");
+			return ns;
+		}) / ROUND_TRIPS;
+
+		const double parallel_for_ms = best_of([&]() {
+			const auto start = Clock::now();
+			pool.parallel_for(0, ITEMS, ITEMS_PER_JOB, [&](size_t first, size_t last) {
+				for (size_t item = first; item < last; item++)
+					results[item] = work(item);
+			});
+			return elapsed_ns(start);
+		}) / 1e6;
+		if (threads == 1)
+			single_thread_ms = parallel_for_ms;
+
+		printf("%7u  %13.1f  %19.1f  %15.2f  %7.2f\n", threads, submit_ns, round_trip_ns,
+			parallel_for_ms, single_thread_ms / parallel_for_ms);
+	}
+	return 0;
+}